@@ -245,6 +245,12 @@ int main(int argc, char **argv) {
 	cout << endl;
 	cout << "Number of unique hashcodes          : " << basis.uniqueHashCodes() ;
 	cout <<                                      " (" << hashCodePercentage*100 << " %)"  << endl;
+	HashSetStatistics hashStat = basis.getStatistics();
+	cout << "Max functions sharing a hashcode    : " << hashStat.maxEqualHashCodes << endl;
+	cout << "Occupied hash table slots           : " << hashStat.occupiedSlots << " / " << hashStat.tableSize << endl;
+	cout << "Avg hash probe length               : " << hashStat.avgProbeLength << endl;
+	cout << "Max hash probe length               : " << hashStat.maxProbeLength << endl;
+	cout << "Max hash cluster length             : " << hashStat.maxClusterLength << endl;
 	cout << "-------------------------------------------------------------" << endl;
 #ifdef HAS_BOOST
 	if(nBasis < 1300 && !vol) {
@@ -27,6 +27,117 @@ ostream& operator<<(ostream& out, const vector<double> vec) {
 	return out;
 }
 
+// evaluates all functions with support on element iEl (and their first derivatives) at the parametric point par
+void elementBasis(const LRSplineSurface *lr, const double *par, int iEl, vector<vector<double> > &result) {
+	lr->computeBasis(par[0], par[1], result, 1, iEl);
+}
+
+void elementBasis(const LRSplineVolume *lr, const double *par, int iEl, vector<vector<double> > &result) {
+	lr->computeBasis(par[0], par[1], par[2], result, 1, iEl);
+}
+
+// maps point i of the tensor grid over the given reference points (first parametric direction running fastest) to element el
+void elementPoint(const Element *el, const vector<vector<double> > &refPoints, int i, double *par) {
+	for(uint d=0; d<refPoints.size(); d++) {
+		int n  = refPoints[d].size();
+		par[d] = el->getParmin(d) + (refPoints[d][i % n]+1)/2*(el->getParmax(d) - el->getParmin(d));
+		i     /= n;
+	}
+}
+
+/**
+ * Evaluates the basis through the Bezier extraction operators and through the Cox-de Boor recursion at the corners, edge
+ * midpoints and center of every element, and returns true if the two agree. Leaves the Bezier extraction cached
+ */
+template <class LRType>
+bool bezierUnchanged(LRType *lr, double tol) {
+	int dim = lr->nVariate();
+	int nPts = (dim == 2) ? 9 : 27;
+	vector<vector<double> > refPoints(dim, vector<double>({-1.0, 0.0, 1.0}));
+	vector<vector<vector<double> > > bezier;
+	vector<vector<double> > coxDeBoor;
+	double par[3];
+	lr->cacheBezierExtraction();
+	for(int iEl=0; iEl<lr->nElements(); iEl++) {
+		for(int i=0; i<nPts; i++) {
+			elementPoint(lr->getElement(iEl), refPoints, i, par);
+			bezier.push_back(vector<vector<double> >());
+			elementBasis(lr, par, iEl, bezier.back());
+		}
+	}
+	lr->clearBezierExtraction();
+	bool correct = true;
+	int k = 0;
+	for(int iEl=0; iEl<lr->nElements(); iEl++) {
+		for(int i=0; i<nPts; i++, k++) {
+			elementPoint(lr->getElement(iEl), refPoints, i, par);
+			elementBasis(lr, par, iEl, coxDeBoor);
+			if(coxDeBoor.size() != bezier[k].size()) {
+				correct = false;
+				continue;
+			}
+			for(uint j=0; j<coxDeBoor.size(); j++)
+				for(uint d=0; d<coxDeBoor[j].size(); d++)
+					if(fabs(coxDeBoor[j][d] - bezier[k][j][d]) > tol)
+						correct = false;
+		}
+	}
+	lr->cacheBezierExtraction();
+	return correct;
+}
+
+/**
+ * Updates the quadrature cache and returns true if the cached values of every element agree with computeBasis() at the
+ * quadrature points
+ */
+template <class LRType>
+bool quadratureUnchanged(LRType *lr, int rule, const vector<vector<double> > &refPoints, double tol) {
+	int dim     = lr->nVariate();
+	int nDerivs = dim+1;
+	int nPts    = 1;
+	for(int d=0; d<dim; d++)
+		nPts *= refPoints[d].size();
+	vector<vector<double> > values;
+	double par[3];
+	lr->updateQuadratureCache();
+	for(int iEl=0; iEl<lr->nElements(); iEl++) {
+		const double *cached = lr->getQuadratureBasis(iEl, rule);
+		int n = lr->getElement(iEl)->nBasisFunctions();
+		if(cached == NULL)
+			return false;
+		for(int q=0; q<nPts; q++) {
+			elementPoint(lr->getElement(iEl), refPoints, q, par);
+			elementBasis(lr, par, iEl, values);
+			if((int) values.size() != n)
+				return false;
+			for(int i=0; i<n; i++)
+				for(int k=0; k<nDerivs; k++)
+					if(fabs(values[i][k] - cached[(q*n + i)*nDerivs + k]) > tol)
+						return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Refines by dimension increase with an error per element which is largest for large elements close to the parametric origin
+ */
+template <class LRType>
+void dimensionIncrease(LRType *lr, double beta) {
+	vector<double> error;
+	for(int iEl=0; iEl<lr->nElements(); iEl++) {
+		const Element *el = lr->getElement(iEl);
+		double size = 1;
+		double dist = 1;
+		for(int d=0; d<lr->nVariate(); d++) {
+			size *= el->getParmax(d) - el->getParmin(d);
+			dist += el->getParmax(d) + el->getParmin(d);
+		}
+		error.push_back(size / dist);
+	}
+	lr->refineByDimensionIncrease(error, beta);
+}
+
 int main(int argc, char **argv) {
 #ifdef TIME_LRSPLINE
 	Profiler prof(argv[0]);
@@ -46,8 +157,13 @@ int main(int argc, char **argv) {
 	double *knot_w      = NULL;
 	int dim             = 4;
 	int nDiagonals      = -1;
+	int nDimIncrease    = -1;
+	int scheme          = -1;
+	double beta         = 0.1;
 	bool rat            = false;
 	bool dumpFile       = false;
+	bool bezier         = false;
+	bool quadrature     = false;
 	bool vol            = false;
 	char *lrInitMesh    = NULL;
 	char *inputFileName = NULL;
@@ -64,8 +180,13 @@ int main(int argc, char **argv) {
 	              "   -knot3 <n>  space-seperated list of the third knot vector (must specify n3 and p3 first)\n"\
 	              "   -dim   <n>  dimension of the controlpoints\n" \
 	              "   -diag  <n>  override inputfile and run diagonal testcase\n"\
+	              "   -dimincrease <n> override inputfile and run n steps of refinement by dimension increase\n"\
+	              "   -beta  <r>  fraction of new functions in each dimension increase step\n"\
+	              "   -scheme <n> refinement scheme for -diag and -dimincrease (0=FULLSPAN, 1=MINSPAN, 2=STRUCTURED)\n"\
 	              "   -in:   <s>  make the LRSplineSurface <s> the initial mesh\n"\
 	              "   -dumpfile   writes an eps- and txt-file of the LR-mesh (bivariate surfaces only)\n"\
+	              "   -bezier     compare Bezier extraction against Cox-de Boor evaluation before and after refinement\n"\
+	              "   -quadrature compare cached basis values at Gauss points against direct evaluation before and after refinement\n"\
 	              "   -help       display (this) help screen\n";
 	parameters << " default values\n";
 	parameters << "   -p   = { " << p1 << ", " << p2 << ", " << p3 << " }\n";
@@ -100,10 +221,20 @@ int main(int argc, char **argv) {
 			lrInitMesh = argv[i]+4;
 		else if(strcmp(argv[i], "-diag") == 0)
 			nDiagonals = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-dimincrease") == 0)
+			nDimIncrease = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-beta") == 0)
+			beta = atof(argv[++i]);
+		else if(strcmp(argv[i], "-scheme") == 0)
+			scheme = atoi(argv[++i]);
 		else if(strcmp(argv[i], "-vol") == 0)
 			vol = true;
 		else if(strcmp(argv[i], "-dumpfile") == 0)
 			dumpFile = true;
+		else if(strcmp(argv[i], "-bezier") == 0)
+			bezier = true;
+		else if(strcmp(argv[i], "-quadrature") == 0)
+			quadrature = true;
 		else if(strcmp(argv[i], "-help") == 0) {
 			cout << "usage: " << argv[0] << "[parameters] <refine inputfile>" << endl << parameters.str();
 			exit(0);
@@ -139,7 +270,7 @@ int main(int argc, char **argv) {
 	} else if(n3 < p3) {
 		cerr << "ERROR: n3 must be greater or equal to p3\n";
 		exit(2);
-	} else if(nDiagonals==-1 && inputFileName == NULL) {
+	} else if(nDiagonals==-1 && nDimIncrease==-1 && inputFileName == NULL) {
 		cerr << "ERROR: Specify input file name\n";
 		cerr << "usage: " << argv[0] << "[parameters] <refine inputfile>" << endl << parameters.str();
 		exit(3);
@@ -247,7 +378,7 @@ int main(int argc, char **argv) {
 	vector<double> startPar2;
 	vector<double> endPar2;
 	vector<int> multiplicity;
-	if(nDiagonals==-1) {
+	if(nDiagonals==-1 && nDimIncrease==-1) {
 		// read input-file 
 		ifstream inputFile;
 		inputFile.open(inputFileName);
@@ -285,8 +416,36 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	// evaluate through the Bezier extraction before refinement, which should then discard it
+	bool bezierCorrect = true;
+	if(bezier)
+		bezierCorrect = (vol) ? bezierUnchanged(lrv, TOL) : bezierUnchanged(lrs, TOL);
 
-	if(nDiagonals==-1) {
+	// cache the basis at the 3x3(x3) Gauss points, which refinement should only recompute where the support has changed
+	bool quadratureCorrect = true;
+	int  rule = -1;
+	vector<vector<double> > gauss((vol) ? 3 : 2, vector<double>({-sqrt(0.6), 0.0, sqrt(0.6)}));
+	if(quadrature) {
+		rule = (vol) ? lrv->addQuadratureRule(gauss, 1) : lrs->addQuadratureRule(gauss, 1);
+		quadratureCorrect = (vol) ? quadratureUnchanged(lrv, rule, gauss, TOL) : quadratureUnchanged(lrs, rule, gauss, TOL);
+	}
+
+	if(scheme != -1) {
+		enum refinementStrategy strat = (scheme == 0) ? LR_FULLSPAN : (scheme == 1) ? LR_MINSPAN : LR_STRUCTURED_MESH;
+		if(vol)
+			lrv->setRefStrat(strat);
+		else
+			lrs->setRefStrat(strat);
+	}
+
+	if(nDimIncrease != -1) {
+		for(int i=0; i<nDimIncrease; i++) {
+			if(vol)
+				dimensionIncrease(lrv, beta);
+			else
+				dimensionIncrease(lrs, beta);
+		}
+	} else if(nDiagonals==-1) {
 		if(vol) {
 			for(uint i=0; i<constParDir.size(); i++) {
 				int c  = constParDir[i]; // constant dir
@@ -324,6 +483,16 @@ int main(int argc, char **argv) {
 	}
 	
 
+	if(bezier) {
+		if((vol) ? lrv->hasBezierExtraction() : lrs->hasBezierExtraction())
+			bezierCorrect = false;
+		else if(!((vol) ? bezierUnchanged(lrv, TOL) : bezierUnchanged(lrs, TOL)))
+			bezierCorrect = false;
+	}
+	if(quadrature)
+		if(!((vol) ? quadratureUnchanged(lrv, rule, gauss, TOL) : quadratureUnchanged(lrs, rule, gauss, TOL)))
+			quadratureCorrect = false;
+
 	// compare function values on edges, knots and in between the knots
 	// as well as all derivatives (up to first derivatives)
 	bool oneFail         = false;
@@ -529,8 +698,12 @@ int main(int argc, char **argv) {
 	}
 	cout << "----------------------------------------\n";
 	cout << "  Linear independent :     " << ((doActualLinTest) ? ((linearIndep) ? "OK" : "FAIL") : "(NOT TESTED)") << endl;
+	if(bezier)
+		cout << "  Bezier extraction  :     " << ((bezierCorrect) ? "OK" : "FAIL") << endl;
+	if(quadrature)
+		cout << "  Quadrature cache   :     " << ((quadratureCorrect) ? "OK" : "FAIL") << endl;
 	cout << "----------------------------------------\n";
-	if(oneFail || !linearIndep)
+	if(oneFail || !linearIndep || !bezierCorrect || !quadratureCorrect)
 		cout << "    test FAILED\n";
 	else
 		cout << "    all assertions passed\n";
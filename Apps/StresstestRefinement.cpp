@@ -27,8 +27,12 @@ int main(int argc, char **argv) {
 	 * splits the bottom left corner by introducing 3 new corner functions for
 	 * each successively inserted cross. The knotlines are distributed uniformely
 	 * throughout the lower left element
+	 *
+	 * MERGE refinement
+	 * as UNIFORM, but inserts each global meshline as two overlapping halves,
+	 * such that every second line is merged into an existing one
 	 */
-	enum refinement_scheme {UNIFORM, CORNER, DIAGONAL} refinement_scheme;
+	enum refinement_scheme {UNIFORM, CORNER, DIAGONAL, MERGE} refinement_scheme;
 
 	// set default parameter values
 	int goalBasisFunctions = 15000;
@@ -58,6 +62,7 @@ int main(int argc, char **argv) {
 	                  "   -unif      UNIFORM refinemen scheme\n"\
 	                  "   -corner    CORNER refinemen scheme\n"\
 	                  "   -diag      DIAGONAL refinemen scheme\n"\
+	                  "   -merge     MERGE refinemen scheme (surfaces only)\n"\
 	                  "   -vol       create a LRSplineVolume instead of Surface\n"\
 	                  "   -dumpfile  writes an eps- and txt-file of the LR-mesh\n"\
 	                  "   -help      display (this) help screen\n"\
@@ -92,6 +97,8 @@ int main(int argc, char **argv) {
 			refinement_scheme = CORNER;
 		else if(strcmp(argv[i], "-diag") == 0)
 			refinement_scheme = DIAGONAL;
+		else if(strcmp(argv[i], "-merge") == 0)
+			refinement_scheme = MERGE;
 		else if(strcmp(argv[i], "-vol") == 0)
 			vol = true;
 		else if(strcmp(argv[i], "-dumpfile") == 0)
@@ -115,6 +122,9 @@ int main(int argc, char **argv) {
 	} else if(n3 < p3) {
 		cerr << "ERROR: n3 must be greater or equal to p3\n";
 		exit(2);
+	} else if(vol && refinement_scheme == MERGE) {
+		cerr << "ERROR: MERGE refinement is only available for surfaces\n";
+		exit(2);
 	}
 
 	// make a uniform integer knot vector
@@ -236,6 +246,25 @@ int main(int argc, char **argv) {
 				v = h/2.0;
 				w = h/2.0;
 			}
+		} else if(refinement_scheme == MERGE) {
+			if(steppingDir == 0) {
+				lr->insert_const_u_edge(u, 0,        0.6*end2);
+				lr->insert_const_u_edge(u, 0.4*end2, end2);
+				u += h;
+				if(u > end1) {
+					steppingDir = 1;
+					v = h/2.0;
+				}
+			} else {
+				lr->insert_const_v_edge(v, 0,        0.6*end1);
+				lr->insert_const_v_edge(v, 0.4*end1, end1);
+				v += h;
+				if(v > end2) {
+					steppingDir = 0;
+					h /= 2.0;
+					u = h/2.0;
+				}
+			}
 		}
 
 		if(vol) {
@@ -254,6 +283,7 @@ int main(int argc, char **argv) {
 		if(refinement_scheme == UNIFORM) cout << "UNIFORM\n";
 		else if(refinement_scheme == CORNER) cout << "CORNER\n";
 		else if(refinement_scheme == DIAGONAL) cout << "DIAGONAL\n";
+		else if(refinement_scheme == MERGE) cout << "MERGE\n";
 		cout << "GOAL basis functions     : " << goalBasisFunctions << endl;
 		cout << "=================================================" << endl;
 		cout << endl;
@@ -267,6 +297,7 @@ int main(int argc, char **argv) {
 	double avgBasisToLine    = 0;
 	int maxBasisToElement    = -1;
 	int minBasisToElement    = 9999999;
+	double avgBasisMemory    = 0;
 
 	HashSet<Basisfunction*> basis    = (vol) ? lv->getAllBasisfunctions() : lr->getAllBasisfunctions();
 	vector<Element*>        elements = (vol) ? lv->getAllElements()       : lr->getAllElements();
@@ -275,9 +306,11 @@ int main(int argc, char **argv) {
 		maxBasisToElement = (maxBasisToElement > nE) ? maxBasisToElement : nE;
 		minBasisToElement = (minBasisToElement < nE) ? minBasisToElement : nE;
 		avgBasisToElement += nE;
+		avgBasisMemory    += b->getMemoryUsage();
 	}
 	avgBasisToElement /= nBasis;
 	avgBasisToLine    /= nBasis;
+	avgBasisMemory    /= nBasis;
 
 	double avgElementToBasis       = 0;
 	double avgSquareElementToBasis = 0;
@@ -299,6 +332,7 @@ int main(int argc, char **argv) {
 	cout << "Min number of Basisfuntion -> Element: " << minBasisToElement << endl;
 	cout << "Max number of Basisfuntion -> Element: " << maxBasisToElement << endl;
 	cout << "Avg number of Basisfuntion -> Element: " << avgBasisToElement << endl;
+	cout << "Avg memory per Basisfunction (bytes) : " << avgBasisMemory    << endl;
 	cout << endl;
 	cout << "Min number of        Element -> Basisfunction: " << minElementToBasis  << endl;
 	cout << "Max number of        Element -> Basisfunction: " << maxElementToBasis  << endl;
@@ -308,6 +342,12 @@ int main(int argc, char **argv) {
 	cout << endl;
 	cout << "Number of unique hashcodes           : " << basis.uniqueHashCodes() ;
 	cout <<                                      " (" << hashCodePercentage*100 << " %)"  << endl;
+	HashSetStatistics hashStat = basis.getStatistics();
+	cout << "Max functions sharing a hashcode     : " << hashStat.maxEqualHashCodes << endl;
+	cout << "Occupied hash table slots            : " << hashStat.occupiedSlots << " / " << hashStat.tableSize << endl;
+	cout << "Avg hash probe length                : " << hashStat.avgProbeLength << endl;
+	cout << "Max hash probe length                : " << hashStat.maxProbeLength << endl;
+	cout << "Max hash cluster length              : " << hashStat.maxClusterLength << endl;
 
 	
 	if(dumpFile) {
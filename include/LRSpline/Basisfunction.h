@@ -8,35 +8,69 @@
 #include "Streamable.h"
 #include "LRSpline.h"
 
+/*! Number of doubles (all knots and the control point) which are stored inside the Basisfunction object itself. This covers
+ *  tricubic volumes with a three-dimensional control point; higher orders fall back to a single heap allocation */
+#define BASISFUNCTION_INLINE_DOUBLES 18
+//! Largest number of local knot vectors (parametric dimension) of a Basisfunction
+#define BASISFUNCTION_MAX_VARIATE    3
+
 namespace LR {
 
 class Element;
 class Meshline;
 
+/************************************************************************************************************************//**
+ * \brief Reference to one local knot vector of a Basisfunction, which behaves like a fixed-size std::vector<double>
+ * \details The knots are owned by the Basisfunction, so the view is only valid as long as the function lives. T is either
+ *          double or const double
+ ***************************************************************************************************************************/
+template <typename T>
+class LocalKnotVector {
+public:
+	LocalKnotVector(T *begin, T *end) : begin_(begin), end_(end) { };
+	//! \brief allows passing a mutable view wherever a const one is expected
+	operator LocalKnotVector<const double>() const { return LocalKnotVector<const double>(begin_, end_); };
+	//! \brief returns a copy of the knots. Explicit, so that copies are never made by accident
+	explicit operator std::vector<double>()  const { return std::vector<double>(begin_, end_); };
+
+	size_t size()                 const { return end_ - begin_; };
+	T&     operator[](size_t i)   const { return begin_[i];     };
+	T&     front()                const { return *begin_;       };
+	T&     back()                 const { return *(end_-1);     };
+	T*     begin()                const { return begin_;        };
+	T*     end()                  const { return end_;          };
+
+private:
+	T *begin_;
+	T *end_;
+};
+
 /************************************************************************************************************************//**
  * \brief Basisfunction class to store the individual B-splines which make up the LR B-spline space
  * \details Stores the local knot vectors corresponding in each parametric direction (two for bivariate surfaces, three for
  *          trivariate volumes) as well as the control point and scaling weight. Used for evaluation of the B-splines and
- *          all their derivatives. The class does also have pointers back to the elements which they have support on
+ *          all their derivatives. The class does also have pointers back to the elements which they have support on.
+ *          All knots and the control point are stored contiguously, inside the object itself for all common orders
  ***************************************************************************************************************************/
 class Basisfunction : public Streamable {
 public:
 	Basisfunction(int dim, int order_u, int order_v);
 	/************************************************************************************************************************//**
-	 * \brief Constructor for arbitray high parametric dimension
+	 * \brief Constructor for arbitray parametric dimension (up to BASISFUNCTION_MAX_VARIATE)
 	 * \param physDim The dimension in the physical space, i.e. the number of components of the controlpoints
 	 * \param parDim The dimension in the parametric space, i.e. the number of local knot vectors
 	 * \param order List of polynomial orders (degree + 1) in each parametric direction
+	 * \throws std::invalid_argument if parDim is larger than BASISFUNCTION_MAX_VARIATE
 	 ***************************************************************************************************************************/
 	template <typename RandomIterator>
 	Basisfunction(int physDim, int parDim, RandomIterator order) {
 		weight_       = 1;
 		id_           = -1;
 		hashCode_     = 0;
-		knots_.resize(parDim);
-		for(int i=0; i<parDim; i++)
-			knots_[i].resize(order[i]+1);
-		controlpoint_.resize(physDim);
+		int p[BASISFUNCTION_MAX_VARIATE];
+		for(int i=0; i<parDim && i<BASISFUNCTION_MAX_VARIATE; i++)
+			p[i] = order[i];
+		allocate(physDim, parDim, p);
 	}
 
 	/************************************************************************************************************************//**
@@ -56,14 +90,12 @@ public:
 		weight_       = weight ;
 		id_           = -1;
 		hashCode_     = 0;
-		knots_.resize(2);
-		knots_[0].resize(order_u+1);
-		knots_[1].resize(order_v+1);
-		controlpoint_.resize(dim);
-
-		std::copy(knot_u,       knot_u       + order_u+1,   knots_[0].begin());
-		std::copy(knot_v,       knot_v       + order_v+1,   knots_[1].begin());
-		std::copy(controlpoint, controlpoint + dim,         controlpoint_.begin());
+		int order[] = {order_u, order_v};
+		allocate(dim, 2, order);
+
+		std::copy(knot_u,       knot_u       + order_u+1,   (*this)[0].begin());
+		std::copy(knot_v,       knot_v       + order_v+1,   (*this)[1].begin());
+		std::copy(controlpoint, controlpoint + dim,         cp());
 	}
 
 	/************************************************************************************************************************//**
@@ -86,17 +118,16 @@ public:
 		weight_       = weight ;
 		id_           = -1;
 		hashCode_     = 0;
-		knots_.resize(3);
-		knots_[0].resize(order_u+1);
-		knots_[1].resize(order_v+1);
-		knots_[2].resize(order_w+1);
-		controlpoint_.resize(dim);
-
-		std::copy(knot_u,       knot_u       + order_u+1,   knots_[0].begin());
-		std::copy(knot_v,       knot_v       + order_v+1,   knots_[1].begin());
-		std::copy(knot_w,       knot_w       + order_w+1,   knots_[2].begin());
-		std::copy(controlpoint, controlpoint + dim,         controlpoint_.begin());
+		int order[] = {order_u, order_v, order_w};
+		allocate(dim, 3, order);
+
+		std::copy(knot_u,       knot_u       + order_u+1,   (*this)[0].begin());
+		std::copy(knot_v,       knot_v       + order_v+1,   (*this)[1].begin());
+		std::copy(knot_w,       knot_w       + order_w+1,   (*this)[2].begin());
+		std::copy(controlpoint, controlpoint + dim,         cp());
 	}
+	Basisfunction(const Basisfunction &other);
+	Basisfunction& operator=(const Basisfunction &other);
 	virtual ~Basisfunction();
 	Basisfunction* copy() const;
 
@@ -106,6 +137,8 @@ public:
 	void   evaluate(std::vector<double> &results, double u, double v, int derivs, bool u_from_right=true, bool v_from_right=true) const;
 	void   evaluate(std::vector<double> &results, double u, double v, double w, int derivs, bool u_from_right=true, bool v_from_right=true, bool w_from_right=true) const;
 	void   evaluate(std::vector<double> &results, const std::vector<double> &parPt, int derivs, const std::vector<bool> &from_right) const;
+	void   evaluate(double *results, const double *parPt, int derivs, const bool *from_right) const;
+	static void evaluate(double *results, const Basisfunction* const *functions, int nFunctions, const double *parPt, int derivs, const bool *from_right);
 
 	// Basisfunction -> Element interatcion (support)
 	bool                            overlaps(Element *el) const ;
@@ -131,37 +164,44 @@ public:
 	void   getGrevilleParameter(std::vector<double> &pt) const;
 	int    getId()                           const { return id_; };
 	int    nSupportedElements()              const { return support_.size(); };
-	int    nVariate()                        const { return knots_.size(); };
-	int    dim()                             const { return controlpoint_.size(); };
-	double getParmin(int i)                  const { return knots_[i][0];     };
-	double getParmax(int i)                  const { return knots_[i].back(); };
-	int    getOrder( int i)                  const { return knots_[i].size()-1;   };
-	std::vector<double>& getknots(int i)           { return knots_[i]; };
-	std::vector<double>::iterator cp()             { return controlpoint_.begin(); };
-	std::vector<double>::const_iterator cp() const { return controlpoint_.begin(); };
-	double cp(int i)                         const { return controlpoint_[i]; };
+	int    nVariate()                        const { return nVariate_; };
+	int    dim()                             const { return dim_; };
+	double getParmin(int i)                  const { return data_[knotStart_[i]];     };
+	double getParmax(int i)                  const { return data_[knotStart_[i+1]-1]; };
+	int    getOrder( int i)                  const { return knotStart_[i+1]-knotStart_[i]-1; };
+	LocalKnotVector<double> getknots(int i)        { return (*this)[i]; };
+	std::vector<double> getknotsVector(int i) const { return std::vector<double>((*this)[i]); };
+	double*       cp()                             { return data_ + knotStart_[nVariate_]; };
+	const double* cp()                       const { return data_ + knotStart_[nVariate_]; };
+	double cp(int i)                         const { return data_[knotStart_[nVariate_]+i]; };
 	double w()                               const { return weight_; };
+	size_t getMemoryUsage()                  const ;
 
 	long hashCode() const ;
+	void resetHashCode();
 
 	// operator overloading
 	bool equals(const Basisfunction &other) const ;
 	bool operator==(const Basisfunction &other) const;
 	void operator+=(const Basisfunction &other) ;
-	std::vector<double>&       operator[](int i)       { return knots_[i]; } ;
-	const std::vector<double>& operator[](int i) const { return knots_[i]; } ;
+	LocalKnotVector<double>       operator[](int i)       { return LocalKnotVector<double>      (data_+knotStart_[i], data_+knotStart_[i+1]); } ;
+	LocalKnotVector<const double> operator[](int i) const { return LocalKnotVector<const double>(data_+knotStart_[i], data_+knotStart_[i+1]); } ;
 
 	// IO-functions
 	virtual void read(std::istream &is);
 	virtual void write(std::ostream &os) const;
 
 private:
+	void allocate(int physDim, int parDim, const int *order);
 
 	int                               id_;
+	short                             nVariate_;                               // number of local knot vectors
+	short                             dim_;                                    // number of control point components
+	short                             knotStart_[BASISFUNCTION_MAX_VARIATE+1]; // knot vector i is stored in [knotStart_[i], knotStart_[i+1]) of data_, followed by the control point
 	double                            weight_;
 	mutable long                      hashCode_;
-	std::vector<double>               controlpoint_;
-	std::vector<std::vector<double> > knots_;
+	double                           *data_;                                   // all knots and the control point, points to inline_ whenever these fit
+	double                            inline_[BASISFUNCTION_INLINE_DOUBLES];
 	std::vector<Element*>             support_;
 
 };
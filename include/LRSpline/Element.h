@@ -3,7 +3,11 @@
 
 #include "Streamable.h"
 #include <vector>
-#include "HashSet.h"
+#include <algorithm>
+#include "ObjectPool.h"
+
+//! Largest parametric dimension of an Element
+#define ELEMENT_MAX_DIM 3
 
 namespace LR {
 
@@ -14,11 +18,17 @@ class Meshline;
  * \brief Element class to partition the parametric space into subrectangles where all Basisfunctions are infitely differentiable
  * \details Stores the parametric bounding box of an element as well as a pointer to all the Basisfunctions which are active
  *          on this element. It is noteworthy to state that all computations on the Element class take place in the parametric
- *          space rather than in the physical (geometry) space. This class is shared by both LRSplineVolume and LRSplineSurface
+ *          space rather than in the physical (geometry) space. This class is shared by both LRSplineVolume and LRSplineSurface.
+ *          The bounding box is stored inline and the supported Basisfunctions in a flat array, such that the element does at
+ *          most one heap allocation
  ***************************************************************************************************************************/
 class Element : public Streamable {
 
 public:
+	//! \brief Iterators over the supported Basisfunctions. Use these names rather than the container type, which may change
+	typedef std::vector<Basisfunction*>::iterator       support_iterator;
+	typedef std::vector<Basisfunction*>::const_iterator const_support_iterator;
+
 	Element();
 	Element(int dim);
 	Element(double start_u, double start_v, double stop_u, double stop_v);
@@ -31,15 +41,16 @@ public:
 	template <typename RandomIterator1,
 	          typename RandomIterator2>
 	Element(int dim, RandomIterator1 lowerLeft, RandomIterator2 upperRight) {
-		min.resize(dim);
-		max.resize(dim);
-		std::copy(lowerLeft,  lowerLeft  + dim, min.begin());
-		std::copy(upperRight, upperRight + dim, max.begin());
+		dim_          = dim;
+		id_           = -1;
+		overloadCount = 0;
+		std::copy(lowerLeft,  lowerLeft  + dim, min);
+		std::copy(upperRight, upperRight + dim, max);
 	}
 	Element(std::vector<double> &lowerLeft, std::vector<double> &upperRight);
 	void removeSupportFunction(Basisfunction *f);
 	void addSupportFunction(Basisfunction *f);
-	Element *split(int splitDim, double par_value);
+	Element *split(int splitDim, double par_value, ObjectPool<Element> *pool=NULL);
 	Element* copy();
         virtual ~Element() {}
 	// get/set methods
@@ -57,11 +68,11 @@ public:
 	double area()           const { return (max[1]-min[1])*(max[0]-min[0]);                  };
 	//! \brief Returns the parametric volume of the element 
 	double volume()         const { return (max[2]-min[2])*(max[1]-min[1])*(max[0]-min[0]);  };
-	HashSet_iterator<Basisfunction*> supportBegin()                 { return support_.begin(); };
-	HashSet_iterator<Basisfunction*> supportEnd()                   { return support_.end();   };
-	HashSet_const_iterator<Basisfunction*> constSupportBegin()const { return support_.begin(); };
-	HashSet_const_iterator<Basisfunction*> constSupportEnd()  const { return support_.end();   };
-	const HashSet<Basisfunction*>& support()                  const { return support_;   };
+	support_iterator                            supportBegin()            { return support_.begin(); };
+	support_iterator                            supportEnd()              { return support_.end();   };
+	const_support_iterator                      constSupportBegin() const { return support_.begin(); };
+	const_support_iterator                      constSupportEnd()   const { return support_.end();   };
+	const std::vector<Basisfunction*>&          support()           const { return support_;         };
 	//! \brief Returns the number of Basisfunctions with support on this element
 	int nBasisFunctions() const           { return support_.size(); };
 	//! \brief Sets a general purpose indexing id to this element
@@ -69,7 +80,7 @@ public:
 	//! \brief Gets the id set by the Element::setId function
 	int  getId() const                    { return id_; };
 	//! \brief Gets the dimension of the element (2 for surfaces, 3 for volumes)
-	int  getDim() const                   { return min.size(); };
+	int  getDim() const                   { return dim_; };
 	void setUmin(double u)                { min[0] = u; };
 	void setVmin(double v)                { min[1] = v; };
 	void setUmax(double u)                { max[0] = u; };
@@ -86,12 +97,14 @@ public:
 	virtual void write(std::ostream &os) const;
 
 private:
-	std::vector<double> min;  // lower left corner in typical 2 or 3 dimensions
-	std::vector<double> max;  // upper right corner 
+	double min[ELEMENT_MAX_DIM];  // lower left corner in typical 2 or 3 dimensions
+	double max[ELEMENT_MAX_DIM];  // upper right corner 
+	int dim_;
 	int id_;
 
-	HashSet<Basisfunction*> support_;
-	std::vector<int> support_ids_; // temporary storage for the read() method only
+	// supported functions in the order they were added
+	std::vector<Basisfunction*> support_;
+	std::vector<int> support_ids_; // temporary storage for the read() and copy() methods only, see updateBasisPointers()
 
 	int overloadCount ;
 	
@@ -0,0 +1,59 @@
+#ifndef ELEMENTTREE_H
+#define ELEMENTTREE_H
+
+#include <vector>
+
+namespace LR {
+
+class Element;
+
+/************************************************************************************************************************//**
+ * \brief Spatial search structure for point location among the elements of an LRSpline
+ * \details The parametric domain is recursively subdivided into quadrants (surfaces) or octants (volumes) until each leaf
+ *          holds only a handful of elements. An element is stored in every leaf it overlaps, so locating the element
+ *          containing a parametric point amounts to descending to a single leaf and testing its few elements, making
+ *          the lookup logarithmic in the number of elements. The tree only stores element indices, so any change to the
+ *          element list of the owning spline must either be reported through addElement() and removeElement(), or the
+ *          tree must be cleared and rebuilt.
+ ***************************************************************************************************************************/
+class ElementTree {
+
+public:
+	ElementTree();
+
+	void build(const std::vector<Element*> &elements, const std::vector<double> &start, const std::vector<double> &end);
+	void clear();
+	//! \brief Returns true if the tree has been built and is up to date with the element list
+	bool isBuilt() const    { return !nodes_.empty(); };
+	//! \brief Returns the total number of nodes (both internal and leaf nodes) in the tree
+	int  nNodes()  const    { return nodes_.size();   };
+
+	void addElement(   const std::vector<Element*> &elements, int iEl);
+	void removeElement(const std::vector<Element*> &elements, int iEl);
+
+	int getElementContaining(const std::vector<Element*> &elements, const double *par) const;
+	void getElementsOverlapping(const std::vector<Element*> &elements, const double *lo, const double *hi, std::vector<int> &result) const;
+
+private:
+	//! \brief Tree node. Internal nodes have 2^dim children stored consecutively starting at index child, leaf nodes have child=-1
+	struct Node {
+		int              child;
+		std::vector<int> elements;
+	};
+
+	void insert(const std::vector<Element*> &elements, int iEl, int node, double *lo, double *hi, int depth);
+	void remove(const std::vector<Element*> &elements, int iEl, int node, double *lo, double *hi);
+	bool contains(const Element *el, const double *par) const;
+	void collect(const std::vector<Element*> &elements, const double *lo, const double *hi, int node, double *nodeLo, double *nodeHi, std::vector<int> &result) const;
+
+	std::vector<Node>   nodes_;
+	std::vector<double> start_;
+	std::vector<double> end_;
+	int                 dim_;
+	int                 leafCapacity_;
+};
+
+} // end namespace LR
+
+#endif
+
@@ -1,14 +1,15 @@
 #ifndef HASHSET_H
 #define HASHSET_H
 
-#include <list>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <iterator>
 #include <cstddef>
 
 /*!
 	\brief HashSet iterator which allows for iteration over the HashSet class
-	\details Internally, the iterator loops over two stl containers, the hashcodes which are stored as buckets in an stl::map
-	         and secondly, an stl::list for hash codes which collide to the same bucket, but are distinct (does not pass equality-test)
+	\details Internally, the iterator is an index into the dense entry array of the HashSet. Erased entries leave a NULL
+	         hole in this array, which the iterator skips
 */
 
 template<typename T>
@@ -17,70 +18,57 @@ class HashSet_iterator
                                T,ptrdiff_t,T*,T&>             // Info about iterator
 {
 
-	typedef typename std::map<long, std::list<T> >::iterator       iter;
-	typedef typename std::map<long, std::list<T> >::const_iterator citer;
-	typedef typename std::list<T>::iterator                        list_iter;
-
     public:
 
 		//! \brief Default constructor
 		HashSet_iterator() {
+			entries = NULL;
+			index   = 0;
 		}
-		
+
 		//! \brief Default constructor
-		//! \param majorIter iterator position in the hashcode map
-		//! \param subIter   iterator position in the linked list for non-unique hash codes
-		//! \param majorEnd  iterator position to the end of the hashcode map
-		HashSet_iterator(iter majorIter, list_iter subIter, iter majorEnd) {
-			this->majorIter = majorIter;
-			this->subIter   = subIter;
-			this->majorEnd  = majorEnd;
+		//! \param entries The dense entry array of the HashSet
+		//! \param index   Position in the entry array (must be a valid entry, or one past the end)
+		HashSet_iterator(std::vector<T> *entries, size_t index) {
+			this->entries = entries;
+			this->index   = index;
 		}
 
-		//! \brief Dereferencing the iterator returns an object of class <T> 
+		//! \brief Dereferencing the iterator returns an object of class <T>
 		T& operator*() const {
-			return *subIter;
+			return (*entries)[index];
 		}
 
-		//! \brief Dereferencing the iterator returns an object of class <T> 
+		//! \brief Dereferencing the iterator returns an object of class <T>
 		T* operator->() const {
-			return &(*subIter);
+			return &(*entries)[index];
 		}
 
 		HashSet_iterator& operator=(const HashSet_iterator &other) {
-			majorEnd  = other.majorEnd ;
-			majorIter = other.majorIter;
-			subIter   = other.subIter  ;
+			entries = other.entries;
+			index   = other.index;
 			return *this;
 		}
 
 		HashSet_iterator& operator++() {
-			subIter++;
-			if(subIter == majorIter->second.end()) {
-				majorIter++;
-				if(majorIter != majorEnd)
-					subIter = majorIter->second.begin();
-			}
+			index++;
+			while(index < entries->size() && (*entries)[index] == NULL)
+				index++;
 			return *this;
 		}
-		/*
-		HashSet_iterator operator++(int i) {
-			myIter += i;
-		}
-		*/
+
 		bool equal(HashSet_iterator const& rhs) const {
-			return majorIter == rhs.majorIter && subIter == rhs.subIter;
+			return entries == rhs.entries && index == rhs.index;
 		}
 
 	private:
-		iter      majorIter;
-		iter      majorEnd;
-		list_iter subIter;
+		std::vector<T> *entries;
+		size_t          index;
 
 };
 
 /*!
-	\brief const version of the HashSet iterator 
+	\brief const version of the HashSet iterator
 */
 template<typename T>
 class HashSet_const_iterator
@@ -88,64 +76,52 @@ class HashSet_const_iterator
                                T,ptrdiff_t,const T*,const T&> // Info about iterator
 {
 
-	typedef typename std::map<long, std::list<T> >::const_iterator iter;
-	typedef typename std::list<T>::const_iterator                  list_iter;
-
     public:
 
 		//! \brief Default constructor
 		HashSet_const_iterator() {
+			entries = NULL;
+			index   = 0;
 		}
-		
+
 		//! \brief Default constructor
-		//! \param majorIter iterator position in the hashcode map
-		//! \param subIter   iterator position in the linked list for non-unique hash codes
-		//! \param majorEnd  iterator position to the end of the hashcode map
-		HashSet_const_iterator(iter majorIter, list_iter subIter, iter majorEnd) {
-			this->majorIter = majorIter;
-			this->subIter   = subIter;
-			this->majorEnd  = majorEnd;
+		//! \param entries The dense entry array of the HashSet
+		//! \param index   Position in the entry array (must be a valid entry, or one past the end)
+		HashSet_const_iterator(const std::vector<T> *entries, size_t index) {
+			this->entries = entries;
+			this->index   = index;
 		}
 
-		//! \brief Dereferencing the iterator returns an object of class <T> 
+		//! \brief Dereferencing the iterator returns an object of class <T>
 		const T& operator*() const {
-			return *subIter;
+			return (*entries)[index];
 		}
 
-		//! \brief Dereferencing the iterator returns an object of class <T> 
+		//! \brief Dereferencing the iterator returns an object of class <T>
 		const T* operator->() const {
-			return &(*subIter);
+			return &(*entries)[index];
 		}
 
 		HashSet_const_iterator& operator=(const HashSet_const_iterator &other) {
-			majorEnd  = other.majorEnd ;
-			majorIter = other.majorIter;
-			subIter   = other.subIter  ;
+			entries = other.entries;
+			index   = other.index;
 			return *this;
 		}
 
 		HashSet_const_iterator& operator++() {
-			subIter++;
-			if(subIter == majorIter->second.end()) {
-				majorIter++;
-				if(majorIter != majorEnd)
-					subIter = majorIter->second.begin();
-			}
+			index++;
+			while(index < entries->size() && (*entries)[index] == NULL)
+				index++;
 			return *this;
 		}
-		/*
-		HashSet_iterator operator++(int i) {
-			myIter += i;
-		}
-		*/
+
 		bool equal(HashSet_const_iterator const& rhs) const {
-			return majorIter == rhs.majorIter && subIter == rhs.subIter;
+			return entries == rhs.entries && index == rhs.index;
 		}
 
 	private:
-		iter      majorIter;
-		iter      majorEnd;
-		list_iter subIter;
+		const std::vector<T> *entries;
+		size_t                index;
 
 };
 
@@ -175,123 +151,222 @@ inline bool operator==(HashSet_const_iterator<T> const& lhs, HashSet_const_itera
 
 
 /*!
-	\brief HashSet container which allows for quick sorting on a non-unique hashfunction, and only contains truly unique elements
-	\details The container requires the class to implement the hashCode function which is used for sorting the results and allow
-	         for access in logarithmic time. Where hash codes coincide, multiple elements are tested by a potentially more time consuming
-	         equals-functions, and unique elements are stored in a linked list at this bucket. It is required that elements that pass
-	         equality-test always produce the same hash code.
+	\brief Statistics on the hashing quality of a HashSet, as reported by HashSet::getStatistics()
+	\details A probe length is the number of table slots inspected before an element is found, i.e. one for an element
+	         stored in its home slot. A cluster is a run of consecutive nonempty slots, which every lookup hashing into it
+	         has to traverse
+*/
+struct HashSetStatistics {
+	int    elements;          //!< number of elements in the container
+	int    uniqueHashCodes;   //!< number of distinct hash codes among the elements
+	int    maxEqualHashCodes; //!< largest number of (unequal) elements sharing one hash code
+	int    tableSize;         //!< number of slots in the lookup table
+	int    occupiedSlots;     //!< number of slots referring to an element
+	int    deletedSlots;      //!< number of slots marked as erased, which are probed past until the next rehash
+	int    maxProbeLength;    //!< longest probe length of any element
+	double avgProbeLength;    //!< average probe length over all elements
+	int    maxClusterLength;  //!< longest run of consecutive nonempty slots
+};
+
+/*!
+	\brief HashSet container which allows for quick lookup on a non-unique hashfunction, and only contains truly unique elements
+	\details The container requires the class to implement the hashCode function which is used for locating elements in
+	         constant time. Where hash codes coincide, multiple elements are tested by a potentially more time consuming
+	         equals-functions. It is required that elements that pass equality-test always produce the same hash code.
+	         The elements (which are pointers) are stored in a dense array in the order they were inserted, which is also the
+	         iteration order. Lookup goes through an open-addressing table (linear probing) of indices into this array, where
+	         the hash code of each element is stored alongside it so that most mismatches are rejected without dereferencing
+	         it. Erasing leaves a hole in the dense array which is skipped during iteration and reclaimed on the next rehash,
+	         which at the latest happens once about half of the dense array are holes.
+	         Erasing never invalidates iterators to other elements, inserting only does so when the table is rehashed
 */
 
 template <class T>
 class HashSet {
 
-typedef typename std::map<long, std::list<T> >::iterator       iter;
-typedef typename std::map<long, std::list<T> >::const_iterator citer;
-typedef typename std::list<T>::iterator                        list_iter;
-
 public:
-	
+
 	//! \brief Default constructor
 	//! \details Creates an empty container
 
 	HashSet() {
-		numb      = 0;
-	}
-	
-	//! \brief Default copy constructor
-	//! \details Creates a copy of the HashSet. 
-	HashSet(const HashSet<T> &other) {
-		data = other.data;
-		numb = other.numb;
+		numb     = 0;
+		used     = 0;
+		first    = 0;
+		modCount = 0;
 	}
 
 	//! \brief insert an element in the container if it does not already exist
 	//! \param obj the element to insert
 	//! \details on the occasion that the element do already exist in the set, no action is taken.
-	//!          Complexity: logarithmic in size, linear in hash collisions
+	//!          Complexity: constant on average, linear in hash collisions
 	void insert(const T &obj) {
 		long hc = obj->hashCode();
-		iter it = data.find(hc);
-
-		if(it == data.end()) {
-			data[hc] = std::list<T>(1,obj);
-			numb++;
-		} else {
-			for(list_iter lit = it->second.begin(); lit != it->second.end(); lit++)
-				if((*lit)->equals(*obj))
-					return;
-			data[hc].push_back(obj);
-			numb++;
-		}
+		if(lookup(obj, hc) >= 0)
+			return;
+		// inserting into a deleted slot does not fill the table any further, but it still grows the dense array
+		if(2*(used+1) > table.size() || entries.size() >= 2*(size_t)numb + 8)
+			rehash();
+
+		// find first free slot (empty or deleted)
+		size_t mask = table.size()-1;
+		size_t slot = bucket(hc);
+		while(table[slot] >= 0)
+			slot = (slot+1) & mask;
+		if(table[slot] == EMPTY)
+			used++;
+		table[slot] = entries.size();
+		entries.push_back(obj);
+		hashes.push_back(hc);
+		numb++;
+		modCount++;
 	}
 
 	//! \brief erase an element in the container if it does exist
 	//! \param obj the element to remove
 	//! \returns 0 if no elements were removed, 1 if it did exist and was successfully removed
 	//! \details on the occasion that the element do already exist in the set, no action is taken.
-	//!          Complexity: logarithmic in size, linear in hash collisions
+	//!          Complexity: constant on average, linear in hash collisions
 	int erase(const T &obj) {
-		long hc = obj->hashCode();
-		iter it = data.find(hc);
-		if(it == data.end())
+		long slot = lookup(obj, obj->hashCode());
+		if(slot < 0)
 			return 0;
-
-		for(list_iter lit = it->second.begin(); lit != it->second.end(); lit++) {
-			if(obj->equals(**lit)) {
-				it->second.erase(lit);
-				if(it->second.size() == 0) {
-					data.erase(it);
-				}
-				numb--;
-				return 1;
-			}
-		}
-		
-		return 0;
+		entries[table[slot]] = NULL;
+		table[slot] = DELETED;
+		numb--;
+		modCount++;
+		return 1;
 	}
 
-	//! \brief Searches the container for an element and returns an iterator to it if found, otherwise it returns an iterator to map::end (the element past the end of the container).
+	//! \brief Searches the container for an element and returns an iterator to it if found, otherwise it returns an iterator to end()
 	//! \param obj The element to search for
-	//! \details Complexity: logarithmic in size, linear in hash collisions
+	//! \details Complexity: constant on average, linear in hash collisions
 	HashSet_iterator<T> find(const T &obj) {
-		long hc = obj->hashCode();
-		iter it = data.find(hc);
-		if(it == data.end())
+		long slot = lookup(obj, obj->hashCode());
+		if(slot < 0)
 			return end();
-		for(list_iter lit = it->second.begin(); lit != it->second.end(); lit++)
-			if(obj->equals(**lit))
-				return HashSet_iterator<T>(it, lit, data.end());
-		
-		return end();
+		return HashSet_iterator<T>(&entries, table[slot]);
 	}
 
-	//! \brief returns the first element, and removes this from the container
+	//! \brief Searches the container for an element and returns an iterator to it if found, otherwise it returns an iterator to end()
+	//! \param obj The element to search for
+	//! \details Complexity: constant on average, linear in hash collisions
+	HashSet_const_iterator<T> find(const T &obj) const {
+		long slot = lookup(obj, obj->hashCode());
+		if(slot < 0)
+			return end();
+		return HashSet_const_iterator<T>(&entries, table[slot]);
+	}
+
+	//! \brief returns the position of an element in the iteration order of the container, or -1 if it does not exist
+	//! \details Positions are not contiguous, but sorting elements by their position reproduces the order of begin() to end().
+	//!          They stay valid until the next insertion or removal. Complexity: constant on average
+	long indexOf(const T &obj) const {
+		long slot = lookup(obj, obj->hashCode());
+		if(slot < 0)
+			return -1;
+		return table[slot];
+	}
+
+	//! \brief returns the first element (the one inserted first), and removes this from the container
 	T pop() {
 		if(numb == 0)
 			return NULL;
-		
-		iter it = data.begin(); 
-		T ans   = it->second.front();
-		it->second.pop_front();
-		if(it->second.size() == 0)
-			data.erase(it);
-
-		numb--;
+		skipHoles();
+		T ans = entries[first];
+		erase(ans);
 		return ans;
 	}
 
 	//! \brief clears the container
 	void clear() {
-		for(iter it = data.begin(); it != data.end(); it++)
-			it->second.clear();
-		data.clear();
-		numb = 0;
+		entries.clear();
+		hashes.clear();
+		table.clear();
+		numb  = 0;
+		used  = 0;
+		first = 0;
+		modCount++;
+	}
+
+	//! \brief returns a counter which changes whenever an element is inserted or removed
+	//! \details Allows the user to tell if data derived from the container (such as indices of the elements) is still valid
+	unsigned long version() const {
+		return modCount;
 	}
 
 	//! \brief returns the number of unique hash codes in this container
 	//! \details this is the number of elements that produce distinct value upon calling T::hashFunction()
 	int uniqueHashCodes() const {
-		return data.size();
+		std::vector<long> codes;
+		codes.reserve(numb);
+		for(size_t i=0; i<entries.size(); i++)
+			if(entries[i] != NULL)
+				codes.push_back(hashes[i]);
+		std::sort(codes.begin(), codes.end());
+		return std::unique(codes.begin(), codes.end()) - codes.begin();
+	}
+
+	//! \brief computes the table occupancy and collision chain lengths of the container
+	//! \details Intended for verifying the quality of T::hashCode() on real data. Complexity: linear in the table size
+	HashSetStatistics getStatistics() const {
+		HashSetStatistics stat;
+		stat.elements          = numb;
+		stat.uniqueHashCodes   = 0;
+		stat.maxEqualHashCodes = 0;
+		stat.tableSize         = table.size();
+		stat.occupiedSlots     = 0;
+		stat.deletedSlots      = 0;
+		stat.maxProbeLength    = 0;
+		stat.avgProbeLength    = 0;
+		stat.maxClusterLength  = 0;
+
+		std::vector<long> codes;
+		codes.reserve(numb);
+		for(size_t i=0; i<entries.size(); i++)
+			if(entries[i] != NULL)
+				codes.push_back(hashes[i]);
+		std::sort(codes.begin(), codes.end());
+		for(size_t i=0; i<codes.size(); ) {
+			size_t j = i+1;
+			while(j<codes.size() && codes[j] == codes[i])
+				j++;
+			stat.uniqueHashCodes++;
+			stat.maxEqualHashCodes = std::max(stat.maxEqualHashCodes, (int) (j-i));
+			i = j;
+		}
+
+		if(table.empty())
+			return stat;
+		size_t mask = table.size()-1;
+		int cluster = 0;
+		for(size_t slot=0; slot<table.size(); slot++) {
+			if(table[slot] == EMPTY) {
+				cluster = 0;
+				continue;
+			}
+			stat.maxClusterLength = std::max(stat.maxClusterLength, ++cluster);
+			if(table[slot] == DELETED) {
+				stat.deletedSlots++;
+				continue;
+			}
+			int probe = ((slot - bucket(hashes[table[slot]])) & mask) + 1;
+			stat.occupiedSlots++;
+			stat.maxProbeLength  = std::max(stat.maxProbeLength, probe);
+			stat.avgProbeLength += probe;
+		}
+		// a cluster may wrap around the end of the table
+		if(table[0] != EMPTY && table.back() != EMPTY) {
+			int wrapped = 0;
+			for(size_t slot=0; slot<table.size() && table[slot] != EMPTY; slot++)
+				wrapped++;
+			for(size_t slot=table.size(); slot>0 && table[slot-1] != EMPTY; slot--)
+				wrapped++;
+			stat.maxClusterLength = std::max(stat.maxClusterLength, std::min(wrapped, (int) table.size()));
+		}
+		if(stat.occupiedSlots > 0)
+			stat.avgProbeLength /= stat.occupiedSlots;
+		return stat;
 	}
 
 	//! \brief returns the number of unique elements in the container
@@ -301,48 +376,100 @@ public:
 	}
 
 	//! \brief iterator to the beginning of the container.
-		//! \details dereferencing the iterator returns an object of class <T>
+	//! \details dereferencing the iterator returns an object of class <T>
 	HashSet_const_iterator<T> begin() const {
-		return HashSet_const_iterator<T>(data.begin(),
-		                                 (numb==0)?dummyLast.end():data.begin()->second.begin(),
-		                                 data.end());
+		size_t i = first;
+		while(i < entries.size() && entries[i] == NULL)
+			i++;
+		return HashSet_const_iterator<T>(&entries, i);
 	}
 
 	//! \brief iterator to one past the last element
 	//! \details dereferencing the iterator returns an object of class <T>
 	HashSet_const_iterator<T> end() const {
-                citer end = data.end();
-                if (!data.empty())
-                  end--;
-		return HashSet_const_iterator<T>(data.end(),
-		                                 (numb==0)?dummyLast.end():end->second.end(),
-		                                 data.end());
+		return HashSet_const_iterator<T>(&entries, entries.size());
 	}
 
 
 	//! \brief iterator to the beginning of the container.
 	//! \details dereferencing the iterator returns an object of class <T>
 	HashSet_iterator<T> begin() {
-		return HashSet_iterator<T>(data.begin(),
-		                           (numb==0)?dummyLast.end():data.begin()->second.begin(),
-		                           data.end());
+		skipHoles();
+		return HashSet_iterator<T>(&entries, first);
 	}
 
 	//! \brief iterator to one past the last element
 	//! \details dereferencing the iterator returns an object of class <T>
 	HashSet_iterator<T> end() {
-                iter end = data.end();
-                if (!data.empty())
-                  end--;
-		return HashSet_iterator<T>(data.end(),
-		                           (numb==0)?dummyLast.end():end->second.end(),
-		                           data.end());
+		return HashSet_iterator<T>(&entries, entries.size());
 	}
 
 private:
-	std::map<long, std::list<T> > data;
-	std::list<T> dummyLast;
-	int  numb;
+	enum { EMPTY = -1, DELETED = -2 }; // special table values
+
+	//! \brief returns the home slot of a hash code. The codes are scrambled once more (Fibonacci hashing) so that poorly mixed
+	//!        codes do not cluster in the table
+	size_t bucket(long hc) const {
+		unsigned long long h = (unsigned long long) hc * 0x9E3779B97F4A7C15ULL;
+		return (size_t) (h >> 32) & (table.size()-1);
+	}
+
+	//! \brief returns the table slot holding an element equal to obj, or -1 if none is found
+	long lookup(const T &obj, long hc) const {
+		if(numb == 0)
+			return -1;
+		size_t mask = table.size()-1;
+		size_t slot = bucket(hc);
+		while(table[slot] != EMPTY) {
+			int i = table[slot];
+			if(i >= 0 && hashes[i] == hc && obj->equals(*entries[i]))
+				return slot;
+			slot = (slot+1) & mask;
+		}
+		return -1;
+	}
+
+	//! \brief advances the position of the first element past any erased entries
+	void skipHoles() {
+		while(first < entries.size() && entries[first] == NULL)
+			first++;
+	}
+
+	//! \brief removes all holes from the dense array (keeping the order) and rebuilds the table at twice the number of elements
+	void rehash() {
+		size_t n = 0;
+		for(size_t i=0; i<entries.size(); i++) {
+			if(entries[i] != NULL) {
+				entries[n] = entries[i];
+				hashes[n]  = hashes[i];
+				n++;
+			}
+		}
+		entries.resize(n);
+		hashes.resize(n);
+		first = 0;
+
+		size_t capacity = 8;
+		while(capacity < 4*(n+1))
+			capacity *= 2;
+		table.assign(capacity, (int) EMPTY);
+		size_t mask = capacity-1;
+		for(size_t i=0; i<n; i++) {
+			size_t slot = bucket(hashes[i]);
+			while(table[slot] != EMPTY)
+				slot = (slot+1) & mask;
+			table[slot] = i;
+		}
+		used = n;
+	}
+
+	std::vector<T>    entries;  // all elements in insertion order, NULL where an element has been erased
+	std::vector<long> hashes;   // hash code of each entry
+	std::vector<int>  table;    // open addressing table of indices into entries (or EMPTY/DELETED)
+	size_t            used;     // number of table slots which are not EMPTY
+	size_t            first;    // no live entries are stored before this index
+	int               numb;
+	unsigned long     modCount; // number of modifications, see version()
 
 };
 
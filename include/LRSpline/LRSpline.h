@@ -3,7 +3,10 @@
 
 #include "HashSet.h"
 #include "Streamable.h"
+#include "ElementTree.h"
+#include "ObjectPool.h"
 #include <vector>
+#include <set>
 
 enum refinementStrategy {
 	LR_MINSPAN         = 0,
@@ -70,6 +73,22 @@ public:
 	virtual void getBezierElement(   int iEl, std::vector<double> &controlPoints) const = 0;
 	virtual void getBezierExtraction(int iEl, std::vector<double> &extractMatrix) const = 0;
 
+	// bezier extraction evaluation mode
+	void cacheBezierExtraction();
+	//! \brief Discards all cached Bezier extraction operators, returning to evaluation by the Cox-de Boor recursion
+	void clearBezierExtraction()       { bezierExtraction_.clear();         };
+	//! \brief Returns true if computeBasis() evaluates through cached Bezier extraction operators
+	bool hasBezierExtraction()   const { return !bezierExtraction_.empty(); };
+
+	// quadrature basis cache
+	int  addQuadratureRule(const std::vector<std::vector<double> > &points, int derivs);
+	void updateQuadratureCache();
+	//! \brief Removes all quadrature rules and their cached values
+	void clearQuadratureCache()                  { quadrature_.clear();        };
+	//! \brief Returns the number of quadrature rules added by addQuadratureRule()
+	int  nQuadratureRules()                const { return quadrature_.size();  };
+	const double* getQuadratureBasis(int iEl, int rule) const;
+
 	// get container iterators
 	std::vector<Element*>::iterator        elementBegin()         { return element_.begin(); };
 	std::vector<Element*>::iterator        elementEnd()           { return element_.end();   };
@@ -83,22 +102,8 @@ public:
 	// traditional get methods
 	Element* getElement(int i)                                     { return element_[i]; };
 	const Element* getElement(int i) const                         { return element_[i]; };
-	Basisfunction* getBasisfunction(int iBasis) {
-		if(iBasis<0 || iBasis>=basis_.size())
-			return NULL;
-		HashSet_iterator<Basisfunction*> it=basis_.begin(); 
-		for(int i=0; i<iBasis; i++)
-			++it;
-		return *it;
-	}
-	const Basisfunction* getBasisfunction(int iBasis) const {
-		if(iBasis<0 || iBasis>=basis_.size())
-			return NULL;
-		HashSet_const_iterator<Basisfunction*> it=basis_.begin(); 
-		for(int i=0; i<iBasis; i++)
-			++it;
-		return *it;
-	}
+	Basisfunction*       getBasisfunction(int iBasis);
+	const Basisfunction* getBasisfunction(int iBasis) const;
 
 	// refinement functions
 	virtual void refineBasisFunction(int index) = 0;
@@ -111,11 +116,12 @@ public:
 	void setRefStrat(enum refinementStrategy strat) { refStrat_        = strat;    };
 	void setRefSymmetry(int symmetry)               { this->symmetry_  = symmetry; };
 	void setRefMultiplicity(int mult)               { refKnotlineMult_ = mult;     };
-	void setMaxTjoints(int n)                       { maxTjoints_      = n;        };
-	void setCloseGaps(bool doClose)                 { doCloseGaps_     = doClose;  };
+	void setMaxTjoints(int n)                       { maxTjoints_      = n;        allElementsDirty_ = true; };
+	void setCloseGaps(bool doClose)                 { doCloseGaps_     = doClose;  allElementsDirty_ = true; };
 	void setMaxAspectRatio(double r, bool aposterioriFix=true) {
 		maxAspectRatio_ = r;
 		doAspectRatioFix_ = aposterioriFix;
+		allElementsDirty_ = true;
 	}
 
 	// set methods
@@ -143,6 +149,17 @@ protected:
 	HashSet<Basisfunction*> basis_;
 	std::vector<Element*> element_;
 
+	// storage for all functions and elements created by this spline (see ObjectPool). Objects are created through
+	// new (pool.allocate()) T(...) and must be released through pool.destroy()
+	ObjectPool<Basisfunction> basisPool_;
+	ObjectPool<Element>       elementPool_;
+
+	// basis_ in iteration order, such that function i (also having id i) is found in constant time. Rebuilt by generateIDs(),
+	// and by both getBasisfunction() whenever basis_ has changed since (basisIndexVersion_ != basis_.version())
+	mutable std::vector<Basisfunction*> basisIndex_;
+	mutable unsigned long               basisIndexVersion_;
+	void buildBasisIndex() const;
+
 	// refinement parameters
 	enum refinementStrategy refStrat_;
 	int                     refKnotlineMult_;
@@ -152,8 +169,38 @@ protected:
 	bool                    doAspectRatioFix_;
 	double                  maxAspectRatio_;
 
-	// caching stuff
-	mutable int lastElementEvaluation;
+	// indices of the elements which may violate the a posteriori mesh conditions (gaps, T-joints, aspect ratio) since these
+	// were last enforced, i.e. all elements touching a line inserted since then. All elements are considered dirty if
+	// allElementsDirty_ is set, which happens when the mesh is created or the conditions change
+	std::set<int>           dirtyElements_;
+	bool                    allElementsDirty_;
+
+	// point location index over element_. Built whenever the element list is created and kept up to date by refinement,
+	// such that all const evaluation methods are free of side effects and may be called concurrently
+	ElementTree elementTree_;
+	bool getBasisfunctionsOverlapping(const double *lo, const double *hi, std::vector<Basisfunction*> &functions) const;
+	void sortInBasisOrder(std::vector<Basisfunction*> &functions) const;
+	void addAffectedEntries(double *lo, double *hi, const std::vector<int> &rank,
+	                        const std::vector<std::pair<Basisfunction*,int> > &functionIndex,
+	                        const std::vector<bool> &generated, size_t &work, std::vector<int> &pending) const;
+
+	// Bezier extraction operator for every element, see cacheBezierExtraction(). Empty unless explicitly requested, and cleared by
+	// any refinement since this changes the element supports
+	std::vector<std::vector<double> > bezierExtraction_;
+
+	static void getBernsteinBasis(double *result, int order, double a, double b, double x, int derivs);
+
+	//! \brief Basis function values at a fixed set of element reference points, stored for all elements in one contiguous arena
+	struct QuadratureCache {
+		std::vector<std::vector<double> > points;  //!< reference points in [-1,1] for each parametric direction (tensor grid)
+		int                               derivs;  //!< number of derivatives stored
+		std::vector<double>               arena;   //!< all values, element by element
+		std::vector<int>                  offset;  //!< start of each element in arena, -1 if the element is stale
+	};
+	std::vector<QuadratureCache> quadrature_;
+
+	void invalidateQuadratureCache();
+	void invalidateQuadratureCache(const std::set<const Element*> &touched);
 
 	static std::vector<double> getUniformKnotVector(int n, int p) {
 		std::vector<double> result(n+p);
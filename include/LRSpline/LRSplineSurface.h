@@ -2,6 +2,7 @@
 #define LRSPLINESURFACE_H
 
 #include <vector>
+#include <map>
 #ifdef HAS_GOTOOLS
 	#include <GoTools/utils/Point.h>
 	#include <GoTools/geometry/SplineSurface.h>
@@ -57,14 +58,14 @@ public:
 	virtual void point(std::vector<double> &pt, double u, double v, int iEl, bool u_from_right, bool v_from_right) const;
 	virtual void point(std::vector<std::vector<double> > &pts, double upar, double vpar, int derivs, int iEl=-1) const;
 	virtual void point(std::vector<std::vector<double> > &pts, double upar, double vpar, int derivs, bool u_from_right, bool v_from_right, int iEl=-1) const;
+	void points(int nPts, const double *upar, const double *vpar, double *result, int derivs=0) const;
 	void computeBasis (double param_u,
 	                   double param_v,
 	                   std::vector<std::vector<double> >& result,
 	                   int derivs=0,
 	                   int iEl=-1 ) const;
-	int getElementContaining(double u, double v) const;
+	int getElementContaining(double u, double v, int hint=-1) const;
 	// TODO: get rid of the iEl argument in evaluation signatures - it's too easy to mess it up (especially with derivatives at multiple-knot boundaries). 
-	//       Try and sort the Elements after all refinements and binary search for the containing point in logarithmic time
 
 	// refinement functions
 	void refineBasisFunction(int index);
@@ -83,6 +84,9 @@ public:
 	void closeGaps(            std::vector<Meshline*>* newLines=NULL);
 	void enforceMaxTjoints(    std::vector<Meshline*>* newLines=NULL);
 	void enforceMaxAspectRatio(std::vector<Meshline*>* newLines=NULL);
+	void closeGaps(            const std::set<int> &elements, std::vector<Meshline*>* newLines=NULL);
+	void enforceMaxTjoints(    const std::set<int> &elements, std::vector<Meshline*>* newLines=NULL);
+	void enforceMaxAspectRatio(const std::set<int> &elements, std::vector<Meshline*>* newLines=NULL);
 
 	// linear independence methods
 	bool isLinearIndepByOverloading(bool verbose) ;
@@ -104,15 +108,15 @@ public:
 	void getGlobalUniqueKnotVector(std::vector<double> &knot_u, std::vector<double> &knot_v) const;
 	void getBezierElement         (int iEl, std::vector<double> &controlPoints)              const;
 	void getBezierExtraction      (int iEl, std::vector<double> &extractMatrix)              const;
-	int nMeshlines()              const                { return meshline_.size(); };
+	int nMeshlines()              const                { return meshline_.size() - nRemovedMeshlines_; };
 
 	// more get-methods
-	std::vector<Meshline*>::iterator       meshlineBegin()         { return meshline_.begin(); };
-	std::vector<Meshline*>::iterator       meshlineEnd()           { return meshline_.end(); };
-	Meshline* getMeshline(int i)                                   { return meshline_[i]; };
-	const Meshline* getMeshline(int i) const                       { return meshline_[i]; };
-	std::vector<Meshline*> getAllMeshlines()                       { return meshline_;    };
-	const std::vector<Meshline*> getAllMeshlines() const           { return meshline_;    };
+	std::vector<Meshline*>::iterator       meshlineBegin()         { compactMeshlines(); return meshline_.begin(); };
+	std::vector<Meshline*>::iterator       meshlineEnd()           { compactMeshlines(); return meshline_.end(); };
+	Meshline* getMeshline(int i)                                   { compactMeshlines(); return meshline_[i]; };
+	const Meshline* getMeshline(int i) const                       { compactMeshlines(); return meshline_[i]; };
+	std::vector<Meshline*> getAllMeshlines()                       { compactMeshlines(); return meshline_;    };
+	const std::vector<Meshline*> getAllMeshlines() const           { compactMeshlines(); return meshline_;    };
 
 	// assorted specialized functions
 	double makeIntegerKnots();
@@ -164,7 +168,7 @@ private:
 	
 		for(int j=0; j<n2; j++)
 			for(int i=0; i<n1; i++)
-				basis_.insert(new Basisfunction(knot_u+i, knot_v+j, coef+(j*n1+i)*(dim+rational), dim, order_u, order_v));
+				basis_.insert(new (basisPool_.allocate()) Basisfunction(knot_u+i, knot_v+j, coef+(j*n1+i)*(dim+rational), dim, order_u, order_v));
 		int unique_u=0;
 		int unique_v=0;
 		for(int i=0; i<n1+p1; i++) {// const u, spanning v
@@ -174,7 +178,7 @@ private:
 				mult++;
 			}
 			unique_u++;
-			meshline_.push_back(new Meshline(false, knot_u[i], knot_v[0], knot_v[n2+p2-1], mult) );
+			meshline_.push_back(new (meshlinePool_.allocate()) Meshline(false, knot_u[i], knot_v[0], knot_v[n2+p2-1], mult) );
 		}
 		for(int i=0; i<n2+p2; i++) {// const v, spanning u
 			int mult = 1;
@@ -183,7 +187,7 @@ private:
 				mult++;
 			}
 			unique_v++;
-			meshline_.push_back(new Meshline(true, knot_v[i], knot_u[0], knot_u[n1+p1-1], mult) );
+			meshline_.push_back(new (meshlinePool_.allocate()) Meshline(true, knot_v[i], knot_u[0], knot_u[n1+p1-1], mult) );
 		}
 		for(int j=0; j<unique_v-1; j++) {
 			for(int i=0; i<unique_u-1; i++) {
@@ -191,20 +195,36 @@ private:
 				double vmin = meshline_[unique_u + j]->const_par_;
 				double umax = meshline_[i+1]->const_par_;
 				double vmax = meshline_[unique_u + j+1]->const_par_;
-				element_.push_back(new Element(umin, vmin, umax, vmax));
+				element_.push_back(new (elementPool_.allocate()) Element(umin, vmin, umax, vmax));
 			}
 		}
 
 		HashSet_iterator<Basisfunction*> it;
 		for(it=basis_.begin(); it!=basis_.end(); ++it)
 			updateSupport(*it);
+
+		elementTree_.build(element_, start_, end_);
+		buildMeshlineIndex();
 	}
 
 	void aPosterioriFixElements();
 	void split(bool insert_in_u, Basisfunction* b, double new_knot, int multiplicity, HashSet<Basisfunction*> &newFunctions);
 	Meshline* insert_line(bool const_u, double const_par, double start, double stop, int multiplicity);
 	
-	std::vector<Meshline*> meshline_;
+	mutable std::vector<Meshline*> meshline_; // may contain NULL entries for removed lines, see compactMeshlines()
+	mutable unsigned int           nRemovedMeshlines_;
+	ObjectPool<Meshline>           meshlinePool_;
+
+	// meshlines sorted by orientation (is_spanning_u) and constant parameter, each list sorted by start_
+	std::map<double, std::vector<Meshline*> > meshlineIndex_[2];
+	void buildMeshlineIndex();
+	void compactMeshlines() const;
+	void addToMeshlineIndex(Meshline *m);
+	void removeFromMeshlineIndex(Meshline *m);
+	void getOverlappingMeshlines(bool span_u, double const_par, double start, double stop, std::vector<Meshline*> &lines) const;
+	void getMeshlinesCrossing(const Basisfunction *b, std::vector<Meshline*> &lines) const;
+	void getTjoints(const Element *el, std::vector<double> &left, std::vector<double> &right, std::vector<double> &top, std::vector<double> &bottom) const;
+	void getElementsTouching(const Meshline *m, std::vector<int> &elements) const;
 
 	// plotting parameters
 	double element_red;
@@ -62,7 +62,7 @@ public:
 	                   std::vector<std::vector<double> >& result,
 	                   int derivs=0,
 	                   int iEl=-1 ) const;
-	int getElementContaining(double u, double v, double w) const;
+	int getElementContaining(double u, double v, double w, int hint=-1) const;
 	// TODO: get rid of the iEl argument in evaluation signatures - it's too easy to mess it up (especially with derivatives at multiple-knot boundaries). 
 	//       Try and sort the Elements after all refinements and binary search for the containing point in logarithmic time
 
@@ -168,7 +168,7 @@ private:
 					RandomIterator2 kv = knot_v + j;
 					RandomIterator3 kw = knot_w + k;
 					RandomIterator4 c = coef + (k*n1*n2 + j*n1 + i)*(dim + rational);
-					basis_.insert(new Basisfunction(ku, kv, kw, c , dim, order_u, order_v, order_w));
+					basis_.insert(new (basisPool_.allocate()) Basisfunction(ku, kv, kw, c , dim, order_u, order_v, order_w));
 		}
 		int unique_u=0;
 		int unique_v=0;
@@ -214,13 +214,15 @@ private:
 					double wmax = meshrect_[unique_v + unique_u + k+1]->stop_[2];
 					double min[] = {umin, vmin, wmin};
 					double max[] = {umax, vmax, wmax};
-					element_.push_back(new Element(3, min, max));
+					element_.push_back(new (elementPool_.allocate()) Element(3, min, max));
 				}
 			}
 		}
 	
 		for(Basisfunction* b : basis_)
 			updateSupport(b);
+
+		elementTree_.build(element_, start_, end_);
 	}
 	
 
@@ -48,6 +48,9 @@ public:
 // even more private (only used for linear independence testing)
 	enum meshlineExtension type_;
 
+// position in the meshline list of the owning LRSplineSurface (used to remove it, and to sort lines found by the index in list order)
+	unsigned long order_;
+
 };
 
 } // end namespace LR
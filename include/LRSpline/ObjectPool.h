@@ -0,0 +1,118 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <type_traits>
+
+namespace LR {
+
+#define OBJECTPOOL_FIRST_CHUNK 256   // number of objects in the first chunk
+#define OBJECTPOOL_MAX_CHUNK   65536 // chunks double in size up to this number of objects
+
+/************************************************************************************************************************//**
+ * \brief Memory pool handing out storage for objects of class T from a few large chunks
+ * \details Each LRSpline owns one pool per building block (Basisfunction, Element and Meshline) and creates its
+ *          objects as new (pool.allocate()) T(...). Storage of destroyed objects is kept on a free list and reused by the
+ *          next allocation, so the many short lived objects created during refinement never reach the system allocator.
+ *          Objects created elsewhere (by plain new, for instance through copy()) may be passed to destroy() as well,
+ *          which then falls back to delete. All chunks are released at once when the pool is destroyed, which must happen
+ *          after all objects in it have been destroyed.
+ ***************************************************************************************************************************/
+template <class T>
+class ObjectPool {
+
+public:
+	ObjectPool() {
+		freeList_  = NULL;
+		used_      = 0;
+		nextChunk_ = OBJECTPOOL_FIRST_CHUNK;
+		nLive_     = 0;
+	}
+
+	~ObjectPool() {
+		for(size_t i=0; i<chunks_.size(); i++)
+			::operator delete(chunks_[i].begin);
+	}
+
+	//! \brief Returns uninitialized storage for one object of class T, to be used by placement new
+	void* allocate() {
+		nLive_++;
+		if(freeList_ != NULL) {
+			Slot *s   = freeList_;
+			freeList_ = s->next;
+			return s;
+		}
+		if(chunks_.empty() || used_ == chunks_.back().size) {
+			Chunk c;
+			c.size  = nextChunk_;
+			c.begin = static_cast<Slot*>(::operator new(c.size * sizeof(Slot)));
+			chunks_.push_back(c);
+			used_ = 0;
+			if(nextChunk_ < OBJECTPOOL_MAX_CHUNK)
+				nextChunk_ *= 2;
+		}
+		return chunks_.back().begin + used_++;
+	}
+
+	//! \brief Calls the destructor of obj and recycles its storage. Objects not created by this pool are deleted
+	void destroy(T *obj) {
+		if(obj == NULL)
+			return;
+		if(!owns(obj)) {
+			delete obj;
+			return;
+		}
+		obj->~T();
+		Slot *s   = reinterpret_cast<Slot*>(obj);
+		s->next   = freeList_;
+		freeList_ = s;
+		nLive_--;
+	}
+
+	//! \brief Returns true if the storage of obj was handed out by this pool
+	bool owns(const T *obj) const {
+		const Slot *s = reinterpret_cast<const Slot*>(obj);
+		for(size_t i=0; i<chunks_.size(); i++)
+			if(s >= chunks_[i].begin && s < chunks_[i].begin + chunks_[i].size)
+				return true;
+		return false;
+	}
+
+	//! \brief Returns the number of objects currently alive in the pool
+	size_t size() const { return nLive_; };
+
+	//! \brief Returns the number of objects the pool can hold without requesting more memory
+	size_t capacity() const {
+		size_t n = 0;
+		for(size_t i=0; i<chunks_.size(); i++)
+			n += chunks_[i].size;
+		return n;
+	}
+
+private:
+	// copying a pool would leave two owners of the same objects
+	ObjectPool(const ObjectPool&);
+	ObjectPool& operator=(const ObjectPool&);
+
+	union Slot {
+		Slot                                                        *next;    // while on the free list
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type   storage; // while holding an object
+	};
+	struct Chunk {
+		Slot   *begin;
+		size_t  size;
+	};
+
+	std::vector<Chunk> chunks_;
+	Slot              *freeList_;  // recycled storage, linked through the Slot::next field
+	size_t             used_;      // number of slots handed out from the last chunk (not counting recycled ones)
+	size_t             nextChunk_; // size of the next chunk to allocate
+	size_t             nLive_;
+
+};
+
+} // end namespace LR
+
+#endif
@@ -53,10 +53,13 @@ public:
   //! \brief Stops profiling of task \a funcName and decrements \a nRunners.
   void stop(const std::string& funcName);
 
+  //! \brief Adds \a n to the event counter \a name.
+  void count(const std::string& name, size_t n) { myCounters[name] += n; }
+
   //! \brief Prints a profiling report for all tasks that have been measured.
   void report(std::ostream& os) const;
   //! \brief Clears the profiler.
-  void clear() { myTimers.clear(); allCPU = allWall = 0.0; nRunners = 0; }
+  void clear() { myTimers.clear(); myCounters.clear(); allCPU = allWall = 0.0; nRunners = 0; }
 
 private:
   //! \brief Stores profiling data for one computational task.
@@ -82,6 +85,8 @@ private:
 
   std::map<std::string,Profile> myTimers; //!< The task profiles with names
 
+  std::map<std::string,size_t> myCounters; //!< Event counters with names
+
   double allCPU;  //!< Accumulated CPU time from all "main" tasks
   double allWall; //!< Accumulated wall clock time of all "main" tasks
 
@@ -109,12 +114,18 @@ namespace utl
     //! \brief The destructor stops the profiling.
     ~prof() { if (profiler) profiler->stop(name); }
   };
+
+  //! \brief Adds \a n to the named event counter of the profiler (if any).
+  inline void count(const char* name, size_t n) { if (profiler) profiler->count(name,n); }
 }
 
 
 //! \brief Macro to add profiling of the local scope.
 #define PROFILE(label) utl::prof _prof(label)
 
+//! \brief Macro to count the number of times some event occurs.
+#define PROFILE_COUNT(label,n) utl::count(label,n)
+
 #if PROFILE_LEVEL >= 1
 #define PROFILE1(label) PROFILE(label)
 #else
@@ -149,6 +160,7 @@ namespace utl
 
 // declare dummy definitions which will do nothing
 #define PROFILE(label)
+#define PROFILE_COUNT(label,n)
 #define PROFILE1(label)
 #define PROFILE2(label)
 #define PROFILE3(label)
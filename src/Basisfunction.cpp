@@ -6,12 +6,22 @@
 #include <cfloat>
 #include <climits>
 #include <cmath>
+#include <cstring>
 #include <set>
+#include <stdexcept>
 
 typedef unsigned int uint;
 
 namespace LR {
 
+#define MAX_EVALUATION_BUFFER       256
+#define MAX_BATCH_EVALUATION_BUFFER 4096
+#define MIN_SPECIALIZED_ORDER       2
+#define MAX_SPECIALIZED_ORDER       4
+#define MAX_SPECIALIZED_DERIVS      3
+#define HASH_KNOT_RESOLUTION        1e-8
+#define HASH_KNOT_OFFSET            0.6180339887498949 // (sqrt(5)-1)/2, places the grid cell boundaries away from rational knots
+
 /************************************************************************************************************************//**
  * \brief Default bivariate constructor
  * \param dim The dimension in the physical space, i.e. the number of components of the controlpoints
@@ -22,10 +32,36 @@ Basisfunction::Basisfunction(int dim, int order_u, int order_v) {
 	weight_       = 1;
 	id_           = -1;
 	hashCode_     = 0;
-	knots_.resize(2);
-	knots_[0].resize(order_u+1);
-	knots_[1].resize(order_v+1);
-	controlpoint_.resize(dim);
+	int order[] = {order_u, order_v};
+	allocate(dim, 2, order);
+}
+
+/************************************************************************************************************************//**
+ * \brief Copy constructor. Copies knots, control point, weight, id and the list of supported elements
+ ***************************************************************************************************************************/
+Basisfunction::Basisfunction(const Basisfunction &other) {
+	data_ = inline_;
+	*this = other;
+}
+
+/************************************************************************************************************************//**
+ * \brief Assignment operator. Copies knots, control point, weight, id and the list of supported elements
+ ***************************************************************************************************************************/
+Basisfunction& Basisfunction::operator=(const Basisfunction &other) {
+	if(this == &other)
+		return *this;
+	if(data_ != inline_)
+		delete[] data_;
+	int order[BASISFUNCTION_MAX_VARIATE];
+	for(int i=0; i<other.nVariate_; i++)
+		order[i] = other.getOrder(i);
+	allocate(other.dim_, other.nVariate_, order);
+	std::copy(other.data_, other.data_ + other.knotStart_[other.nVariate_] + other.dim_, data_);
+	id_       = other.id_;
+	weight_   = other.weight_;
+	hashCode_ = other.hashCode_;
+	support_  = other.support_;
+	return *this;
 }
 
 /************************************************************************************************************************//**
@@ -35,6 +71,41 @@ Basisfunction::~Basisfunction() {
 	PROFILE("Function destruction");
 	for(uint i=0; i<support_.size(); i++)
 		support_[i]->removeSupportFunction( (Basisfunction*) this);
+	if(data_ != inline_)
+		delete[] data_;
+}
+
+/************************************************************************************************************************//**
+ * \brief Sets up the storage of the knot vectors and control point. All values are set to zero
+ * \param physDim The dimension in the physical space, i.e. the number of components of the controlpoints
+ * \param parDim The dimension in the parametric space, i.e. the number of local knot vectors
+ * \param order List of polynomial orders (degree + 1) in each parametric direction
+ * \details All knot vectors and the control point are stored back to back in one array, which is placed inside the object
+ *          unless it is larger than BASISFUNCTION_INLINE_DOUBLES. Any previous heap storage must be released by the caller
+ * \throws std::invalid_argument if parDim is larger than BASISFUNCTION_MAX_VARIATE. Nothing is changed in that case
+ ***************************************************************************************************************************/
+void Basisfunction::allocate(int physDim, int parDim, const int *order) {
+	if(parDim > BASISFUNCTION_MAX_VARIATE)
+		throw std::invalid_argument("Basisfunction: unsupported number of parametric directions");
+	nVariate_     = parDim;
+	dim_          = physDim;
+	knotStart_[0] = 0;
+	for(int i=0; i<parDim; i++)
+		knotStart_[i+1] = knotStart_[i] + order[i]+1;
+	int n = knotStart_[parDim] + physDim;
+	data_ = (n <= BASISFUNCTION_INLINE_DOUBLES) ? inline_ : new double[n];
+	std::fill(data_, data_+n, 0.0);
+}
+
+/************************************************************************************************************************//**
+ * \brief Get the number of bytes used by this B-spline, including heap storage but not the Element objects it points to
+ ***************************************************************************************************************************/
+size_t Basisfunction::getMemoryUsage() const {
+	size_t bytes = sizeof(Basisfunction);
+	if(data_ != inline_)
+		bytes += (knotStart_[nVariate_] + dim_) * sizeof(double);
+	bytes += support_.capacity() * sizeof(Element*);
+	return bytes;
 }
 
 #ifdef HAS_GOTOOLS
@@ -45,12 +116,12 @@ Basisfunction::~Basisfunction() {
 Go::Point Basisfunction::getGrevilleParameter() const {
 	Go::Point ans(2);
         ans[0] = ans[1] = 0.0;
-	for(uint i=1; i<knots_[0].size()-1; i++)
-		ans[0] += knots_[0][i];
-	for(uint i=1; i<knots_[1].size()-1; i++)
-		ans[1] += knots_[1][i];
-	ans[0] /= (knots_[0].size()-2);
-	ans[1] /= (knots_[1].size()-2);
+	for(uint i=1; i<(*this)[0].size()-1; i++)
+		ans[0] += (*this)[0][i];
+	for(uint i=1; i<(*this)[1].size()-1; i++)
+		ans[1] += (*this)[1][i];
+	ans[0] /= ((*this)[0].size()-2);
+	ans[1] /= ((*this)[1].size()-2);
 	return ans;
 }
 
@@ -59,9 +130,9 @@ Go::Point Basisfunction::getGrevilleParameter() const {
  * \param pt [out] The ascociated control point to this B-spline
  ***************************************************************************************************************************/
 void Basisfunction::getControlPoint(Go::Point &pt) const {
-	pt.resize(controlpoint_.size());
-	for(uint d=0; d<controlpoint_.size(); d++)
-		pt[d] = controlpoint_[d];
+	pt.resize(dim_);
+	for(uint d=0; d<dim_; d++)
+		pt[d] = cp()[d];
 }
 #endif
 
@@ -71,12 +142,12 @@ void Basisfunction::getControlPoint(Go::Point &pt) const {
  * \returns The internal knot average 
  ***************************************************************************************************************************/
 void Basisfunction::getGrevilleParameter(std::vector<double> &pt) const {
-	pt.resize(knots_.size());
-	for(uint i=0; i<knots_.size(); i++) {
+	pt.resize(nVariate_);
+	for(int i=0; i<nVariate_; i++) {
 		pt[i] = 0;
-		for(uint j=0; j<knots_[i].size()-1; j++)
-			pt[i] += knots_[i][j];
-		pt[i] /= (knots_[i].size()-2);
+		for(uint j=0; j<(*this)[i].size()-1; j++)
+			pt[i] += (*this)[i][j];
+		pt[i] /= ((*this)[i].size()-2);
 	}
 }
 
@@ -87,13 +158,13 @@ void Basisfunction::getGrevilleParameter(std::vector<double> &pt) const {
 void Basisfunction::evaluate(std::vector<double> &results, double u, double v, int derivs, bool u_from_right, bool v_from_right) const {
 	results.resize((derivs+1)*(derivs+2)/2);
 	fill(results.begin(), results.end(), 0);
-	if(knots_[0][0] > u || u > knots_[0].back())
+	if((*this)[0][0] > u || u > (*this)[0].back())
 		return ;
-	if(knots_[1][0] > v || v > knots_[1].back())
+	if((*this)[1][0] > v || v > (*this)[1].back())
 		return ;
 
-	double ans_u[knots_[0].size()-1];
-	double ans_v[knots_[1].size()-1];
+	double ans_u[(*this)[0].size()-1];
+	double ans_v[(*this)[1].size()-1];
 	// double diff_u = 0;
 	// double diff_v = 0;
 	// double diff_2u[3];
@@ -104,74 +175,74 @@ void Basisfunction::evaluate(std::vector<double> &results, double u, double v, i
 	diff_v = new double*[derivs+1];
 	int diff_level;
 
-	for(uint i=0; i<knots_[0].size()-1; i++) {
+	for(uint i=0; i<(*this)[0].size()-1; i++) {
 		if(u_from_right)
-			ans_u[i] = (knots_[0][i] <= u && u <  knots_[0][i+1]) ? 1 : 0;
+			ans_u[i] = ((*this)[0][i] <= u && u <  (*this)[0][i+1]) ? 1 : 0;
 		else 
-			ans_u[i] = (knots_[0][i] <  u && u <= knots_[0][i+1]) ? 1 : 0;
+			ans_u[i] = ((*this)[0][i] <  u && u <= (*this)[0][i+1]) ? 1 : 0;
 	}
 
-	diff_level = knots_[0].size()-2;
-	for(uint n=1; n<knots_[0].size()-1; n++, diff_level--) {
+	diff_level = (*this)[0].size()-2;
+	for(uint n=1; n<(*this)[0].size()-1; n++, diff_level--) {
 		if(diff_level <= derivs) {
 			diff_u[diff_level] = new double[diff_level+1];
 			for(int j=0; j<=diff_level; j++)
 				diff_u[diff_level][j] = ans_u[j];
 		}
 		for(int d = diff_level; d<= derivs; d++) {
-			for(uint j=0; j<knots_[0].size()-1-n; j++) {
-				diff_u[d][j]  = (knots_[0][ j+n ]==knots_[0][ j ]) ? 0 : (   n   )/(knots_[0][j+n]  -knots_[0][ j ])*diff_u[d][ j ];
-				diff_u[d][j] -= (knots_[0][j+n+1]==knots_[0][j+1]) ? 0 : (   n   )/(knots_[0][j+n+1]-knots_[0][j+1])*diff_u[d][j+1];
+			for(uint j=0; j<(*this)[0].size()-1-n; j++) {
+				diff_u[d][j]  = ((*this)[0][ j+n ]==(*this)[0][ j ]) ? 0 : (   n   )/((*this)[0][j+n]  -(*this)[0][ j ])*diff_u[d][ j ];
+				diff_u[d][j] -= ((*this)[0][j+n+1]==(*this)[0][j+1]) ? 0 : (   n   )/((*this)[0][j+n+1]-(*this)[0][j+1])*diff_u[d][j+1];
 			}
 		}
 
 #if 0
 // kept this to maybe make it easier to see the logic behind evaluating arbitrary high derivatives
-		if(n==knots_[0].size()-2)
-			for(int j=0; j<=knots_[0].size()-n; j++)
+		if(n==(*this)[0].size()-2)
+			for(int j=0; j<=(*this)[0].size()-n; j++)
 				diff_2u[j] = ans_u[j];
-		if(n>=knots_[0].size()-2) {
-			for(int j=0; j<knots_[0].size()-n; j++) {
-				diff_2u[j]  = (knots_[0][ j+n ]==knots_[0][ j ]) ? 0 : (   n   )/(knots_[0][j+n]  -knots_[0][ j ])*diff_2u[ j ];
-				diff_2u[j] -= (knots_[0][j+n+1]==knots_[0][j+1]) ? 0 : (   n   )/(knots_[0][j+n+1]-knots_[0][j+1])*diff_2u[j+1];
+		if(n>=(*this)[0].size()-2) {
+			for(int j=0; j<(*this)[0].size()-n; j++) {
+				diff_2u[j]  = ((*this)[0][ j+n ]==(*this)[0][ j ]) ? 0 : (   n   )/((*this)[0][j+n]  -(*this)[0][ j ])*diff_2u[ j ];
+				diff_2u[j] -= ((*this)[0][j+n+1]==(*this)[0][j+1]) ? 0 : (   n   )/((*this)[0][j+n+1]-(*this)[0][j+1])*diff_2u[j+1];
 			}
 		}
-		if(n==knots_[0].size()-1) {
+		if(n==(*this)[0].size()-1) {
 			int j=0;
-			diff_u  = (knots_[0][ j+n ]==knots_[0][ j ]) ? 0 : (   knots_[0].size()-1   )/(knots_[0][j+n]  -knots_[0][ j ])*ans_u[ j ];
-			diff_u -= (knots_[0][j+n+1]==knots_[0][j+1]) ? 0 : (   knots_[0].size()-1   )/(knots_[0][j+n+1]-knots_[0][j+1])*ans_u[j+1];
+			diff_u  = ((*this)[0][ j+n ]==(*this)[0][ j ]) ? 0 : (   (*this)[0].size()-1   )/((*this)[0][j+n]  -(*this)[0][ j ])*ans_u[ j ];
+			diff_u -= ((*this)[0][j+n+1]==(*this)[0][j+1]) ? 0 : (   (*this)[0].size()-1   )/((*this)[0][j+n+1]-(*this)[0][j+1])*ans_u[j+1];
 		}
 #endif
-		for(uint j=0; j<knots_[0].size()-1-n; j++) {
-			ans_u[j]  = (knots_[0][ j+n ]==knots_[0][ j ]) ? 0 : (  u-knots_[0][j]  )/(knots_[0][j+n]  -knots_[0][ j ])*ans_u[ j ];
-			ans_u[j] += (knots_[0][j+n+1]==knots_[0][j+1]) ? 0 : (knots_[0][j+n+1]-u)/(knots_[0][j+n+1]-knots_[0][j+1])*ans_u[j+1];
+		for(uint j=0; j<(*this)[0].size()-1-n; j++) {
+			ans_u[j]  = ((*this)[0][ j+n ]==(*this)[0][ j ]) ? 0 : (  u-(*this)[0][j]  )/((*this)[0][j+n]  -(*this)[0][ j ])*ans_u[ j ];
+			ans_u[j] += ((*this)[0][j+n+1]==(*this)[0][j+1]) ? 0 : ((*this)[0][j+n+1]-u)/((*this)[0][j+n+1]-(*this)[0][j+1])*ans_u[j+1];
 		}
 	}
 					   
-	for(uint i=0; i<knots_[1].size()-1; i++) {
+	for(uint i=0; i<(*this)[1].size()-1; i++) {
 		if(v_from_right)
-			ans_v[i] = (knots_[1][i] <= v && v <  knots_[1][i+1]) ? 1 : 0;
+			ans_v[i] = ((*this)[1][i] <= v && v <  (*this)[1][i+1]) ? 1 : 0;
 		else 
-			ans_v[i] = (knots_[1][i] <  v && v <= knots_[1][i+1]) ? 1 : 0;
+			ans_v[i] = ((*this)[1][i] <  v && v <= (*this)[1][i+1]) ? 1 : 0;
 	}
 
-	diff_level = knots_[1].size()-2;
-	for(uint n=1; n<knots_[1].size()-1; n++, diff_level--) {
+	diff_level = (*this)[1].size()-2;
+	for(uint n=1; n<(*this)[1].size()-1; n++, diff_level--) {
 		if(diff_level <= derivs) {
 			diff_v[diff_level] = new double[diff_level+1];
 			for(int j=0; j<=diff_level; j++)
 				diff_v[diff_level][j] = ans_v[j];
 		}
 		for(int d = diff_level; d<= derivs; d++) {
-			for(uint j=0; j<knots_[1].size()-1-n; j++) {
-				diff_v[d][j]  = (knots_[1][ j+n ]==knots_[1][ j ]) ? 0 : (   n   )/(knots_[1][j+n]  -knots_[1][ j ])*diff_v[d][ j ];
-				diff_v[d][j] -= (knots_[1][j+n+1]==knots_[1][j+1]) ? 0 : (   n   )/(knots_[1][j+n+1]-knots_[1][j+1])*diff_v[d][j+1];
+			for(uint j=0; j<(*this)[1].size()-1-n; j++) {
+				diff_v[d][j]  = ((*this)[1][ j+n ]==(*this)[1][ j ]) ? 0 : (   n   )/((*this)[1][j+n]  -(*this)[1][ j ])*diff_v[d][ j ];
+				diff_v[d][j] -= ((*this)[1][j+n+1]==(*this)[1][j+1]) ? 0 : (   n   )/((*this)[1][j+n+1]-(*this)[1][j+1])*diff_v[d][j+1];
 			}
 		}
 	
-		for(uint j=0; j<knots_[1].size()-1-n; j++) {
-			ans_v[j]  = (knots_[1][ j+n ]==knots_[1][ j ]) ? 0 : (  v-knots_[1][j]  )/(knots_[1][j+n]  -knots_[1][ j ])*ans_v[ j ];
-			ans_v[j] += (knots_[1][j+n+1]==knots_[1][j+1]) ? 0 : (knots_[1][j+n+1]-v)/(knots_[1][j+n+1]-knots_[1][j+1])*ans_v[j+1];
+		for(uint j=0; j<(*this)[1].size()-1-n; j++) {
+			ans_v[j]  = ((*this)[1][ j+n ]==(*this)[1][ j ]) ? 0 : (  v-(*this)[1][j]  )/((*this)[1][j+n]  -(*this)[1][ j ])*ans_v[ j ];
+			ans_v[j] += ((*this)[1][j+n+1]==(*this)[1][j+1]) ? 0 : ((*this)[1][j+n+1]-v)/((*this)[1][j+n+1]-(*this)[1][j+1])*ans_v[j+1];
 		}
 	}
 
@@ -194,36 +265,36 @@ void Basisfunction::evaluate(std::vector<double> &results, double u, double v, i
 }
 
 double Basisfunction::evaluate(double u, double v, bool u_from_right, bool v_from_right) const {
-	if(knots_[0][0] > u || u > knots_[0].back())
+	if((*this)[0][0] > u || u > (*this)[0].back())
 		return 0;
-	if(knots_[1][0] > v || v > knots_[1].back())
+	if((*this)[1][0] > v || v > (*this)[1].back())
 		return 0;
 
-	double ans_u[knots_[0].size()-1];
-	double ans_v[knots_[1].size()-1];
+	double ans_u[(*this)[0].size()-1];
+	double ans_v[(*this)[1].size()-1];
 
-	for(uint i=0; i<knots_[0].size()-1; i++) {
+	for(uint i=0; i<(*this)[0].size()-1; i++) {
 		if(u_from_right)
-			ans_u[i] = (knots_[0][i] <= u && u <  knots_[0][i+1]) ? 1 : 0;
+			ans_u[i] = ((*this)[0][i] <= u && u <  (*this)[0][i+1]) ? 1 : 0;
 		else 
-			ans_u[i] = (knots_[0][i] <  u && u <= knots_[0][i+1]) ? 1 : 0;
+			ans_u[i] = ((*this)[0][i] <  u && u <= (*this)[0][i+1]) ? 1 : 0;
 	}
-	for(uint n=1; n<knots_[0].size()-1; n++)
-		for(uint j=0; j<knots_[0].size()-1-n; j++) {
-			ans_u[j]  = (knots_[0][ j+n ]==knots_[0][ j ]) ? 0 : (  u-knots_[0][j]  )/(knots_[0][j+n]  -knots_[0][ j ])*ans_u[ j ];
-			ans_u[j] += (knots_[0][j+n+1]==knots_[0][j+1]) ? 0 : (knots_[0][j+n+1]-u)/(knots_[0][j+n+1]-knots_[0][j+1])*ans_u[j+1];
+	for(uint n=1; n<(*this)[0].size()-1; n++)
+		for(uint j=0; j<(*this)[0].size()-1-n; j++) {
+			ans_u[j]  = ((*this)[0][ j+n ]==(*this)[0][ j ]) ? 0 : (  u-(*this)[0][j]  )/((*this)[0][j+n]  -(*this)[0][ j ])*ans_u[ j ];
+			ans_u[j] += ((*this)[0][j+n+1]==(*this)[0][j+1]) ? 0 : ((*this)[0][j+n+1]-u)/((*this)[0][j+n+1]-(*this)[0][j+1])*ans_u[j+1];
 	}
 					   
-	for(uint i=0; i<knots_[1].size()-1; i++) {
+	for(uint i=0; i<(*this)[1].size()-1; i++) {
 		if(v_from_right)
-			ans_v[i] = (knots_[1][i] <= v && v <  knots_[1][i+1]) ? 1 : 0;
+			ans_v[i] = ((*this)[1][i] <= v && v <  (*this)[1][i+1]) ? 1 : 0;
 		else 
-			ans_v[i] = (knots_[1][i] <  v && v <= knots_[1][i+1]) ? 1 : 0;
+			ans_v[i] = ((*this)[1][i] <  v && v <= (*this)[1][i+1]) ? 1 : 0;
 	}
-	for(uint n=1; n<knots_[1].size()-1; n++)
-		for(uint j=0; j<knots_[1].size()-1-n; j++) {
-			ans_v[j]  = (knots_[1][ j+n ]==knots_[1][ j ]) ? 0 : (  v-knots_[1][j]  )/(knots_[1][j+n]  -knots_[1][ j ])*ans_v[ j ];
-			ans_v[j] += (knots_[1][j+n+1]==knots_[1][j+1]) ? 0 : (knots_[1][j+n+1]-v)/(knots_[1][j+n+1]-knots_[1][j+1])*ans_v[j+1];
+	for(uint n=1; n<(*this)[1].size()-1; n++)
+		for(uint j=0; j<(*this)[1].size()-1-n; j++) {
+			ans_v[j]  = ((*this)[1][ j+n ]==(*this)[1][ j ]) ? 0 : (  v-(*this)[1][j]  )/((*this)[1][j+n]  -(*this)[1][ j ])*ans_v[ j ];
+			ans_v[j] += ((*this)[1][j+n+1]==(*this)[1][j+1]) ? 0 : ((*this)[1][j+n+1]-v)/((*this)[1][j+n+1]-(*this)[1][j+1])*ans_v[j+1];
 	}
 
 	return ans_u[0]*ans_v[0]*weight_;
@@ -239,15 +310,11 @@ double Basisfunction::evaluate(double u, double v, bool u_from_right, bool v_fro
  * \return The B-spline evaluated at the chosen parametric coordinate
  ***************************************************************************************************************************/
 double Basisfunction::evaluate(double u, double v, bool u_from_right, bool v_from_right) const {
-	std::vector<double> results;
-	std::vector<double> parPt(2);
-	std::vector<bool>   fromRight(2);
-	parPt[0] = u;
-	parPt[1] = v;
-	fromRight[0] = u_from_right;
-	fromRight[1] = v_from_right;
-	evaluate(results, parPt, 0, fromRight);
-	return results[0];
+	double result;
+	double parPt[]     = {u, v};
+	bool   fromRight[] = {u_from_right, v_from_right};
+	evaluate(&result, parPt, 0, fromRight);
+	return result;
 }
 
 /************************************************************************************************************************//**
@@ -261,17 +328,11 @@ double Basisfunction::evaluate(double u, double v, bool u_from_right, bool v_fro
  * \return The B-spline evaluated at the chosen parametric coordinate
  ***************************************************************************************************************************/
 double Basisfunction::evaluate(double u, double v, double w, bool u_from_right, bool v_from_right, bool w_from_right) const {
-	std::vector<double> results;
-	std::vector<double> parPt(3);
-	std::vector<bool>   fromRight(3);
-	parPt[0] = u;
-	parPt[1] = v;
-	parPt[2] = w;
-	fromRight[0] = u_from_right;
-	fromRight[1] = v_from_right;
-	fromRight[2] = w_from_right;
-	evaluate(results, parPt, 0, fromRight);
-	return results[0];
+	double result;
+	double parPt[]     = {u, v, w};
+	bool   fromRight[] = {u_from_right, v_from_right, w_from_right};
+	evaluate(&result, parPt, 0, fromRight);
+	return result;
 }
 
 /************************************************************************************************************************//**
@@ -285,13 +346,10 @@ double Basisfunction::evaluate(double u, double v, double w, bool u_from_right,
  * \param v_from_right Evaluate second parametric coordinate in the limit from the right
  ***************************************************************************************************************************/
 void Basisfunction::evaluate(std::vector<double> &results, double u, double v, int derivs, bool u_from_right, bool v_from_right) const {
-	std::vector<double> parPt(2);
-	std::vector<bool>   fromRight(2);
-	parPt[0] = u;
-	parPt[1] = v;
-	fromRight[0] = u_from_right;
-	fromRight[1] = v_from_right;
-	evaluate(results, parPt, derivs, fromRight);
+	double parPt[]     = {u, v};
+	bool   fromRight[] = {u_from_right, v_from_right};
+	results.resize((derivs+1)*(derivs+2)/2);
+	evaluate(&results[0], parPt, derivs, fromRight);
 }
 
 /************************************************************************************************************************//**
@@ -307,39 +365,11 @@ void Basisfunction::evaluate(std::vector<double> &results, double u, double v, i
  * \param w_from_right Evaluate third parametric coordinate in the limit from the right
  ***************************************************************************************************************************/
 void Basisfunction::evaluate(std::vector<double> &results, double u, double v, double w, int derivs, bool u_from_right, bool v_from_right, bool w_from_right) const {
-	std::vector<double> parPt(3);
-	std::vector<bool>   fromRight(3);
-	parPt[0] = u;
-	parPt[1] = v;
-	parPt[2] = w;
-	fromRight[0] = u_from_right;
-	fromRight[1] = v_from_right;
-	fromRight[2] = w_from_right;
-	evaluate(results, parPt, derivs, fromRight);
-}
-
-// funky recursive algorithm for collecting derivative results. Best illustrated by examples:
-// ordering for bivariate second derivatives:  1, dx,dy, d2x,dxdy,d2y
-// ordering for trivariate second derivatives: 1, dx,dy,dz, d2x,dxdy,dxdz,d2y,dydz,d2z
-// ordering for trivariate third derivatives:  1,
-//                                            dx,dy,dz,
-//                                            d2x,dxdy,dxdz,d2y,dydz,d2z,
-//                                            d3x,d2xdy,d2xdz,dxd2y,dxdydz,dxd2z,d3y,d2ydz,dyd2z,d3z
-void collectResults(std::vector<double>::iterator &result,
-                    double product,
-                    std::vector<std::vector<std::vector<double> > > &diff,
-                    int derivsLeft,
-                    uint dim) {
-	if(dim == diff.size()-1) {
-		*result *= product*diff.back()[derivsLeft][0];
-		result++;
-		return;
-	}
-	for(int d=derivsLeft; d>-1; d--) {
-		double ans = diff[dim][d][0];
-		collectResults(result, ans*product, diff, derivsLeft-d, dim+1);
-	}
-};
+	double parPt[]     = {u, v, w};
+	bool   fromRight[] = {u_from_right, v_from_right, w_from_right};
+	results.resize((derivs+1)*(derivs+2)*(2*derivs+6)/12);
+	evaluate(&results[0], parPt, derivs, fromRight);
+}
 
 /************************************************************************************************************************//**
  * \brief evaluates a general B-spline (currently only bivariate and trivariate supported - small fix to extend, but not now)
@@ -356,7 +386,7 @@ void collectResults(std::vector<double>::iterator &result,
  * Trivariate splines up to third order: 1, dx,dy,dz, d2x,dxdy,dxdz,d2y,dydz,d2z, d3x,d2xdy,d2xdz,dxd2y,dxdydz,dxd2z,d3y,d2ydz,dyd2z,d3z
  ***************************************************************************************************************************/
 void Basisfunction::evaluate(std::vector<double> &results, const std::vector<double> &parPt, int derivs, const std::vector<bool> &from_right) const {
-	uint dim = knots_.size();
+	uint dim = nVariate_;
 	if(dim != parPt.size() || dim != from_right.size()) {
 		std::cerr << "Error Basisfunction::evalate(...) parametric dimension mismatch" << std::endl;
 		exit(9230);
@@ -370,53 +400,319 @@ void Basisfunction::evaluate(std::vector<double> &results, const std::vector<dou
 		std::cerr << "Error Basisfunction::evalate(...) for parametric dimension other than 2 or 3" << std::endl;
 		exit(9231);
 	}
-	fill(results.begin(), results.end(), 0.0);
 
-	std::vector<std::vector<double> >               ans(dim);
-	std::vector<std::vector<std::vector<double> > > diff(dim);
-	uint i = 0;
-	for(std::vector<double> knot : knots_) {
-		if(knot[0] > parPt[i] || parPt[i] > knot.back())
-			return;
-		ans[i].resize(knot.size()-1);
-		for(uint j=0; j<knot.size()-1; j++) {
-			if(from_right[i])
-				ans[i][j] = (knot[j] <= parPt[i] && parPt[i] <  knot[j+1]) ? 1 : 0;
-			else
-				ans[i][j] = (knot[j] <  parPt[i] && parPt[i] <= knot[j+1]) ? 1 : 0;
+	bool fromRight[3];
+	for(uint i=0; i<dim; i++)
+		fromRight[i] = from_right[i];
+	evaluate(&results[0], &parPt[0], derivs, fromRight);
+}
+
+/************************************************************************************************************************//**
+ * \brief evaluates a univariate B-spline and its derivatives by the Cox-de Boor recursion
+ * \param result [out] The B-spline and its derivatives up to order derivs (derivs+1 values)
+ * \param knot The local knot vector (p+1 values)
+ * \param p The polynomial order of the B-spline
+ * \param x Parametric evaluation point
+ * \param derivs Number of derivatives requested
+ * \param from_right Evaluate in the limit from the right
+ * \param scratch Temporary storage of at least (derivs+2)*p values
+ * \return false if x is outside the support of the B-spline
+ * \details Declared inline so that the specialized versions below get the loop bounds p and derivs as compile-time constants
+ ***************************************************************************************************************************/
+static inline bool evaluateUnivariate(double *result, const double *knot, int p, double x, int derivs, bool from_right, double *scratch) {
+	if(knot[0] > x || x > knot[p])
+		return false;
+
+	// ans holds the B-splines of increasing degree, diff the same for all derivatives (stored as rows of length p)
+	double *ans  = scratch;
+	double *diff = scratch + p;
+	for(int j=0; j<p; j++) {
+		if(from_right)
+			ans[j] = (knot[j] <= x && x <  knot[j+1]) ? 1 : 0;
+		else
+			ans[j] = (knot[j] <  x && x <= knot[j+1]) ? 1 : 0;
+	}
+
+	int diff_level = p-1;
+	for(int n=1; n<p; n++, diff_level--) {
+		if(diff_level <= derivs) {
+			for(int j=0; j<=diff_level; j++)
+				diff[diff_level*p + j] = ans[j];
 		}
+		for(int d = diff_level; d<=derivs && d<p; d++) {
+			double *row = diff + d*p;
+			for(int j=0; j<p-n; j++) {
+				row[j]  = (knot[ j+n ]==knot[ j ]) ? 0 : double(n)/(knot[j+n]  -knot[ j ])*row[ j ];
+				row[j] -= (knot[j+n+1]==knot[j+1]) ? 0 : double(n)/(knot[j+n+1]-knot[j+1])*row[j+1];
+			}
+		}
+		for(int j=0; j<p-n; j++) {
+			ans[j]  = (knot[ j+n ]==knot[ j ]) ? 0 : (    x-knot[j]    )/(knot[j+n]  -knot[ j ])*ans[ j ];
+			ans[j] += (knot[j+n+1]==knot[j+1]) ? 0 : (knot[j+n+1]-   x )/(knot[j+n+1]-knot[j+1])*ans[j+1];
+		}
+	}
+
+	result[0] = ans[0];
+	for(int d=1; d<=derivs; d++)
+		result[d] = (d < p) ? diff[d*p] : 0.0; // derivatives beyond the polynomial degree vanish
+	return true;
+}
 
-		diff[i].resize(derivs+1);
-		int diff_level = knot.size()-2;
-		for(uint n=1; n<knot.size()-1; n++, diff_level--) {
-			if(diff_level <= derivs) {
-				diff[i][diff_level].resize(diff_level+1);
-				for(int j=0; j<=diff_level; j++)
-					diff[i][diff_level][j] = ans[i][j];
+/************************************************************************************************************************//**
+ * \brief evaluates a univariate B-spline of fixed order P and its first D derivatives
+ * \details Same arguments as the runtime-generic evaluateUnivariate(), but with the order and number of derivatives as template
+ *          parameters the compiler is free to unroll all loops of the recursion. Uses its own scratch space on the stack
+ ***************************************************************************************************************************/
+template<int P, int D>
+static bool evaluateUnivariate(double *result, const double *knot, double x, bool from_right) {
+	double scratch[(D+2)*P];
+	return evaluateUnivariate(result, knot, P, x, D, from_right, scratch);
+}
+
+typedef bool (*UnivariateEvaluator)(double*, const double*, double, bool);
+
+//! \brief Dispatch table of the specialized univariate evaluators, indexed by [order-MIN_SPECIALIZED_ORDER][derivs]
+static const UnivariateEvaluator specializedEvaluator[MAX_SPECIALIZED_ORDER-MIN_SPECIALIZED_ORDER+1][MAX_SPECIALIZED_DERIVS+1] = {
+	{evaluateUnivariate<2,0>, evaluateUnivariate<2,1>, evaluateUnivariate<2,2>, evaluateUnivariate<2,3>},
+	{evaluateUnivariate<3,0>, evaluateUnivariate<3,1>, evaluateUnivariate<3,2>, evaluateUnivariate<3,3>},
+	{evaluateUnivariate<4,0>, evaluateUnivariate<4,1>, evaluateUnivariate<4,2>, evaluateUnivariate<4,3>}
+};
+
+/************************************************************************************************************************//**
+ * \brief evaluates a bivariate or trivariate B-spline without any memory allocation. All other evaluate functions end up here
+ * \param results [out] Array of all results, which must have room for (derivs+1)*(derivs+2)/2 (bivariate) or
+ *                      (derivs+1)*(derivs+2)*(2*derivs+6)/12 (trivariate) values. Ordering is the same as the vector version
+ * \param parPt Parametric evaluation point (2 or 3 values)
+ * \param derivs Number of derivatives requested
+ * \param from_right For each parametric direction, evaluate in the limit from the right
+ ***************************************************************************************************************************/
+void Basisfunction::evaluate(double *results, const double *parPt, int derivs, const bool *from_right) const {
+	int dim = nVariate_;
+	int nResults;
+	if(dim == 2) {
+		nResults = (derivs+1)*(derivs+2)/2;
+	} else if(dim == 3) {
+		nResults = (derivs+1)*(derivs+2)*(2*derivs+6)/12;
+	} else {
+		std::cerr << "Error Basisfunction::evalate(...) for parametric dimension other than 2 or 3" << std::endl;
+		exit(9231);
+	}
+	std::fill(results, results+nResults, 0.0);
+
+	// univariate results are stored first in the buffer, followed by scratch space for the recursion
+	int maxP = 0;
+	for(int i=0; i<dim; i++)
+		maxP = std::max(maxP, (int) (*this)[i].size()-1);
+	int nBuffer = dim*(derivs+1) + (derivs+2)*maxP;
+	double stackBuffer[MAX_EVALUATION_BUFFER];
+	std::vector<double> heapBuffer;
+	double *buffer = stackBuffer;
+	if(nBuffer > MAX_EVALUATION_BUFFER) { // unusually high order or number of derivatives
+		heapBuffer.resize(nBuffer);
+		buffer = &heapBuffer[0];
+	}
+
+	const double *diff[3];
+	for(int i=0; i<dim; i++) {
+		diff[i] = buffer + i*(derivs+1);
+		const double *knot = &(*this)[i][0];
+		int p = (*this)[i].size()-1;
+		bool inside;
+		if(MIN_SPECIALIZED_ORDER <= p && p <= MAX_SPECIALIZED_ORDER && derivs <= MAX_SPECIALIZED_DERIVS)
+			inside = specializedEvaluator[p-MIN_SPECIALIZED_ORDER][derivs](buffer + i*(derivs+1), knot, parPt[i], from_right[i]);
+		else
+			inside = evaluateUnivariate(buffer + i*(derivs+1), knot, p, parPt[i], derivs, from_right[i], buffer + dim*(derivs+1));
+		if(!inside)
+			return;
+	}
+
+	// collect results. Ordering for bivariate second derivatives:  1, dx,dy, d2x,dxdy,d2y
+	//                  ordering for trivariate second derivatives: 1, dx,dy,dz, d2x,dxdy,dxdz,d2y,dydz,d2z
+	//                  ordering for trivariate third derivatives:  1,
+	//                                                              dx,dy,dz,
+	//                                                              d2x,dxdy,dxdz,d2y,dydz,d2z,
+	//                                                              d3x,d2xdy,d2xdz,dxd2y,dxdydz,dxd2z,d3y,d2ydz,dyd2z,d3z
+	double *res = results;
+	for(int totDeriv=0; totDeriv<=derivs; totDeriv++) {
+		for(int d0=totDeriv; d0>-1; d0--) {
+			if(dim == 2) {
+				*res++ = weight_ * (diff[0][d0]*diff[1][totDeriv-d0]);
+			} else {
+				for(int d1=totDeriv-d0; d1>-1; d1--)
+					*res++ = weight_ * ((diff[1][d1]*diff[0][d0]) * diff[2][totDeriv-d0-d1]);
 			}
-			for(int d = diff_level; d<= derivs; d++) {
-				for(uint j=0; j<knot.size()-1-n; j++) {
-					diff[i][d][j]  = (knot[ j+n ]==knot[ j ]) ? 0 : (   n   )/(knot[j+n]  -knot[ j ])*diff[i][d][ j ];
-					diff[i][d][j] -= (knot[j+n+1]==knot[j+1]) ? 0 : (   n   )/(knot[j+n+1]-knot[j+1])*diff[i][d][j+1];
+		}
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief evaluates a batch of univariate B-splines of the same order at the same point by the Cox-de Boor recursion
+ * \param result [out] The B-splines and their derivatives. Derivative d of function f is stored at result[d*N+f]
+ * \param knot The local knot vectors, stored interleaved: knot j of function f is at knot[j*N+f]
+ * \param p The polynomial order of all B-splines
+ * \param N The number of B-splines
+ * \param x Parametric evaluation point
+ * \param derivs Number of derivatives requested
+ * \param from_right Evaluate in the limit from the right
+ * \param scratch Temporary storage of at least (derivs+2)*p*N values
+ * \details Performs exactly the same operations as evaluateUnivariate() for each function, but with the function index as the
+ *          innermost loop. This gives contiguous, branch-free inner loops which the compiler can vectorize. Functions which
+ *          do not contain x in their support are not treated specially here, they are masked out by the caller
+ ***************************************************************************************************************************/
+static void evaluateUnivariateBatch(double *result, const double *knot, int p, int N, double x, int derivs, bool from_right, double *scratch) {
+	double *ans  = scratch;
+	double *diff = scratch + p*N;
+	for(int j=0; j<p; j++) {
+		const double *k0 = knot +  j   *N;
+		const double *k1 = knot + (j+1)*N;
+		double       *a  = ans  +  j   *N;
+		if(from_right)
+			for(int f=0; f<N; f++)
+				a[f] = (k0[f] <= x && x <  k1[f]) ? 1 : 0;
+		else
+			for(int f=0; f<N; f++)
+				a[f] = (k0[f] <  x && x <= k1[f]) ? 1 : 0;
+	}
+
+	int diff_level = p-1;
+	for(int n=1; n<p; n++, diff_level--) {
+		if(diff_level <= derivs)
+			std::copy(ans, ans + (diff_level+1)*N, diff + diff_level*p*N);
+		for(int d = diff_level; d<=derivs && d<p; d++) {
+			double *row = diff + d*p*N;
+			for(int j=0; j<p-n; j++) {
+				const double *k0 = knot + (j    )*N;
+				const double *k1 = knot + (j+1  )*N;
+				const double *kn = knot + (j+n  )*N;
+				const double *kn1= knot + (j+n+1)*N;
+				double       *r0 = row  +  j    *N;
+				const double *r1 = row  + (j+1) *N;
+				for(int f=0; f<N; f++) {
+					r0[f]  = (kn [f]==k0[f]) ? 0 : double(n)/(kn [f]-k0[f])*r0[f];
+					r0[f] -= (kn1[f]==k1[f]) ? 0 : double(n)/(kn1[f]-k1[f])*r1[f];
 				}
 			}
-			for(uint j=0; j<knot.size()-1-n; j++) {
-				ans[i][j]  = (knot[ j+n ]==knot[ j ]) ? 0 : (  parPt[i]-knot[j]  )/(knot[j+n]  -knot[ j ])*ans[i][ j ];
-				ans[i][j] += (knot[j+n+1]==knot[j+1]) ? 0 : (knot[j+n+1]-parPt[i])/(knot[j+n+1]-knot[j+1])*ans[i][j+1];
+		}
+		for(int j=0; j<p-n; j++) {
+			const double *k0 = knot + (j    )*N;
+			const double *k1 = knot + (j+1  )*N;
+			const double *kn = knot + (j+n  )*N;
+			const double *kn1= knot + (j+n+1)*N;
+			double       *a0 = ans  +  j    *N;
+			const double *a1 = ans  + (j+1) *N;
+			for(int f=0; f<N; f++) {
+				a0[f]  = (kn [f]==k0[f]) ? 0 : (    x-k0[f] )/(kn [f]-k0[f])*a0[f];
+				a0[f] += (kn1[f]==k1[f]) ? 0 : (kn1[f]-   x )/(kn1[f]-k1[f])*a1[f];
 			}
 		}
+	}
 
-		i++;
+	std::copy(ans, ans+N, result);
+	for(int d=1; d<=derivs; d++) {
+		if(d < p)
+			std::copy(diff + d*p*N, diff + d*p*N + N, result + d*N);
+		else
+			std::fill(result + d*N, result + (d+1)*N, 0.0); // derivatives beyond the polynomial degree vanish
 	}
-			
-	// collect results
-	for(i=0; i<dim; i++)
-		diff[i][0] = ans[i];
+}
 
-	fill(results.begin(), results.end(), weight_);
-	std::vector<double>::iterator resIt = results.begin();
-	for(int totDeriv=0; totDeriv<=derivs; totDeriv++)
-		collectResults(resIt, 1.0, diff, totDeriv, 0);
+/************************************************************************************************************************//**
+ * \brief evaluates a batch of bivariate or trivariate B-splines at the same parametric point
+ * \param results [out] Array of all results, which must have room for nResults values per function, where nResults is
+ *                      (derivs+1)*(derivs+2)/2 (bivariate) or (derivs+1)*(derivs+2)*(2*derivs+6)/12 (trivariate). Derivative k
+ *                      of function f is stored at results[f*nResults+k] using the same ordering as the single-function version
+ * \param functions The B-splines to evaluate, typically all functions with support on one element
+ * \param nFunctions The number of B-splines
+ * \param parPt Parametric evaluation point (2 or 3 values)
+ * \param derivs Number of derivatives requested
+ * \param from_right For each parametric direction, evaluate in the limit from the right
+ * \details Gives identical results to calling evaluate() on each function separately. The local knot vectors of all functions
+ *          are packed into interleaved arrays such that the recursion is done for all functions at once with the function
+ *          index as the innermost (vectorizable) loop. Falls back to evaluating the functions one by one if they are not all
+ *          of the same order
+ ***************************************************************************************************************************/
+void Basisfunction::evaluate(double *results, const Basisfunction* const *functions, int nFunctions, const double *parPt, int derivs, const bool *from_right) {
+	if(nFunctions == 0)
+		return;
+	int dim = functions[0]->nVariate_;
+	int nResults;
+	if(dim == 2) {
+		nResults = (derivs+1)*(derivs+2)/2;
+	} else if(dim == 3) {
+		nResults = (derivs+1)*(derivs+2)*(2*derivs+6)/12;
+	} else {
+		std::cerr << "Error Basisfunction::evalate(...) for parametric dimension other than 2 or 3" << std::endl;
+		exit(9231);
+	}
+
+	int N    = nFunctions;
+	int p[3];
+	int maxP = 0;
+	for(int i=0; i<dim; i++) {
+		p[i] = (*functions[0])[i].size()-1;
+		maxP = std::max(maxP, p[i]);
+	}
+	bool sameOrder = true;
+	for(int f=1; f<N && sameOrder; f++)
+		for(int i=0; i<dim; i++)
+			if((int) (*functions[f])[i].size()-1 != p[i])
+				sameOrder = false;
+	if(!sameOrder) {
+		for(int f=0; f<N; f++)
+			functions[f]->evaluate(results + f*nResults, parPt, derivs, from_right);
+		return;
+	}
+
+	// buffer layout: univariate results for all directions, inside-support mask, knot vectors and finally recursion scratch space
+	int nKnots = 0;
+	for(int i=0; i<dim; i++)
+		nKnots += (p[i]+1)*N;
+	int nBuffer = dim*(derivs+1)*N + N + nKnots + (derivs+2)*maxP*N;
+	double stackBuffer[MAX_BATCH_EVALUATION_BUFFER];
+	std::vector<double> heapBuffer;
+	double *buffer = stackBuffer;
+	if(nBuffer > MAX_BATCH_EVALUATION_BUFFER) { // very many functions or unusually high order
+		heapBuffer.resize(nBuffer);
+		buffer = &heapBuffer[0];
+	}
+	double *inside  = buffer + dim*(derivs+1)*N;
+	double *knot    = inside + N;
+	double *scratch = knot   + nKnots;
+
+	std::fill(inside, inside+N, 1.0);
+	const double *diff[3];
+	for(int i=0; i<dim; i++) {
+		for(int f=0; f<N; f++) {
+			LocalKnotVector<const double> k = (*functions[f])[i];
+			for(int j=0; j<=p[i]; j++)
+				knot[j*N+f] = k[j];
+			if(k[0] > parPt[i] || parPt[i] > k[p[i]])
+				inside[f] = 0.0;
+		}
+		double *res = buffer + i*(derivs+1)*N;
+		diff[i]     = res;
+		evaluateUnivariateBatch(res, knot, p[i], N, parPt[i], derivs, from_right[i], scratch);
+	}
+
+	// collect results, same ordering as the single-function evaluate()
+	for(int f=0; f<N; f++) {
+		double *res = results + f*nResults;
+		if(inside[f] == 0.0) {
+			std::fill(res, res+nResults, 0.0);
+			continue;
+		}
+		double weight = functions[f]->weight_;
+		for(int totDeriv=0; totDeriv<=derivs; totDeriv++) {
+			for(int d0=totDeriv; d0>-1; d0--) {
+				if(dim == 2) {
+					*res++ = weight * (diff[0][d0*N+f]*diff[1][(totDeriv-d0)*N+f]);
+				} else {
+					for(int d1=totDeriv-d0; d1>-1; d1--)
+						*res++ = weight * ((diff[1][d1*N+f]*diff[0][d0*N+f]) * diff[2][(totDeriv-d0-d1)*N+f]);
+				}
+			}
+		}
+	}
 }
 
 /************************************************************************************************************************//**
@@ -424,9 +720,9 @@ void Basisfunction::evaluate(std::vector<double> &results, const std::vector<dou
  * \param pt [out] The ascociated control point to this B-spline
  ***************************************************************************************************************************/
 void Basisfunction::getControlPoint(std::vector<double> &pt) const {
-	pt.resize(controlpoint_.size());
-	for(uint d=0; d<controlpoint_.size(); d++)
-		pt[d] = controlpoint_[d];
+	pt.resize(dim_);
+	for(int d=0; d<dim_; d++)
+		pt[d] = cp()[d];
 }
 
 /************************************************************************************************************************//**
@@ -462,10 +758,10 @@ bool Basisfunction::addSupport(Element *el) {
  * \brief Returns true if this B-splines support overlaps with the elements size
  ***************************************************************************************************************************/
 bool Basisfunction::overlaps(Element *el) const {
-	for(uint i=0; i<knots_.size(); i++) {
-		if(knots_[i][0]     >= el->getParmax(i))
+	for(int i=0; i<nVariate_; i++) {
+		if((*this)[i][0]     >= el->getParmax(i))
 			return false;
-		if(knots_[i].back() <= el->getParmin(i))
+		if((*this)[i].back() <= el->getParmin(i))
 			return false;
 	}
 	return true;
@@ -493,7 +789,7 @@ std::vector<Element*> Basisfunction::getExtendedSupport() {
  * \return A list of elements which describes the minimal extended support
  ***************************************************************************************************************************/
 std::vector<Element*> Basisfunction::getMinimalExtendedSupport() {
-	if(knots_.size() != 2) {
+	if(nVariate_ != 2) {
 		std::cerr << "Error: Basisfunction::getMinimalExtendedSupport() only for bivariate B-splines" << std::endl;
 		exit(86136);
 	}
@@ -501,10 +797,10 @@ std::vector<Element*> Basisfunction::getMinimalExtendedSupport() {
 	double min_dv = DBL_MAX;
 	Basisfunction *smallestGuy = NULL;
 
-	bool edgeUmin = (knots_[0][0] == knots_[0][knots_[0].size()-2]);
-	bool edgeUmax = (knots_[0][1] == knots_[0][knots_[0].size()-1]);
-	bool edgeVmin = (knots_[1][0] == knots_[1][knots_[1].size()-2]);
-	bool edgeVmax = (knots_[1][1] == knots_[1][knots_[1].size()-1]);
+	bool edgeUmin = ((*this)[0][0] == (*this)[0][(*this)[0].size()-2]);
+	bool edgeUmax = ((*this)[0][1] == (*this)[0][(*this)[0].size()-1]);
+	bool edgeVmin = ((*this)[1][0] == (*this)[1][(*this)[1].size()-2]);
+	bool edgeVmax = ((*this)[1][1] == (*this)[1][(*this)[1].size()-1]);
 
 	if(! (edgeUmin || edgeUmax) )
 		min_du = getParmax(0) - getParmin(0);
@@ -562,58 +858,85 @@ std::vector<Element*> Basisfunction::getMinimalExtendedSupport() {
  * \param dim New control point dimension
  ***************************************************************************************************************************/
 void Basisfunction::setDimension(int dim) {
-	controlpoint_.resize(dim);
-	for(int i=0; i<dim; i++)
-		controlpoint_[i]  = 0.0;
+	double *oldData = data_;
+	std::vector<double> knots(data_, data_ + knotStart_[nVariate_]);
+	int order[BASISFUNCTION_MAX_VARIATE];
+	for(int i=0; i<nVariate_; i++)
+		order[i] = getOrder(i);
+	allocate(dim, nVariate_, order);
+	std::copy(knots.begin(), knots.end(), data_);
+	if(oldData != inline_ && oldData != data_)
+		delete[] oldData;
+}
+
+/************************************************************************************************************************//**
+ * \brief Scrambles the bits of a 64-bit word (the splitmix64 finalizer), used to combine knots into a hash code
+ ***************************************************************************************************************************/
+static inline unsigned long long mixBits(unsigned long long h) {
+	h ^= h >> 30;
+	h *= 0xBF58476D1CE4E5B9ULL;
+	h ^= h >> 27;
+	h *= 0x94D049BB133111EBULL;
+	h ^= h >> 31;
+	return h;
 }
 
 /************************************************************************************************************************//**
  * \brief Get the B-spline hash code for storage in the HashSet container
  * \returns some "random" long based on the local knot vector
+ * \details Every knot is snapped to a grid cell of width HASH_KNOT_RESOLUTION, which is coarser than the tolerance used by
+ *          equals(), and the index of the cell is mixed into the code. Functions which differ in any knot by more than the
+ *          grid spacing thus (almost surely) get distinct codes, while knots which are equal up to round-off usually fall
+ *          in the same cell. Knots lying within round-off (or, for knots that differ by more than round-off, within the
+ *          equals() tolerance) of a cell boundary may however land in different cells, and equal functions then get
+ *          different codes, which the HashSet does not detect. To keep this away from the knots that refinement produces,
+ *          the cell boundaries are shifted by an irrational fraction of the spacing rather than lying at the midpoints
+ *          (where, e.g., every odd multiple of 1/512 would sit). Knots m/q in [0,4] with q a power of two up to 2^20, or
+ *          any q up to 200, are then at least 1e-5 cells from a boundary, far beyond round-off.
+ *          The code is cached, and must be reset by resetHashCode() if the knots are changed afterwards
  ***************************************************************************************************************************/
 long Basisfunction::hashCode() const {
 	if(hashCode_ != 0)
 		return hashCode_;
 
-	int nKnots = 0;
-	for(std::vector<double> knot : knots_)
-		nKnots += knot.size();
-
-	int bitsFromEach = (sizeof(long)*8) / nKnots;
-	int bitsLeft     = (sizeof(long)*8) % nKnots;
-	int offset       = 0;
-	for(std::vector<double> knot : knots_) {
-		for(uint i=0; i<knot.size()-1; i++) {
-			long randInt = log2(fabs(knot[i]))*120000;
-			// int randInt = log2(fabs(knot[i]+1))*343;
-			// int randInt = (i%2==0) ? knot[i] : log2(fabs(knot[i]));
-			if(knot[i]==0) randInt = 0;
-			// int randInt = log2(fabs(knot[i]));
-			// int randInt = knot[i];
-			long mask    = 0;
-			for(int k=0; k<bitsFromEach + (bitsLeft>0); k++)
-				mask |= (1<<k);
-			hashCode_ |= ((long) (randInt & mask)) << offset;
-			offset += bitsFromEach + (bitsLeft>0);
-			bitsLeft--;
+	unsigned long long h = 0x243F6A8885A308D3ULL;
+	for(int i=0; i<nVariate_; i++) {
+		LocalKnotVector<const double> knot = (*this)[i];
+		h = mixBits(h ^ knot.size());
+		for(double k : knot) {
+			double snapped = floor(k / HASH_KNOT_RESOLUTION + HASH_KNOT_OFFSET); // never -0.0, as the offset is positive
+			unsigned long long bits;
+			memcpy(&bits, &snapped, sizeof(double));
+			h = mixBits(h ^ bits);
 		}
 	}
+	hashCode_ = (long) h;
+	if(hashCode_ == 0) // zero is reserved for "not computed"
+		hashCode_ = 1;
 	return hashCode_;
 }
 
+/************************************************************************************************************************//**
+ * \brief Clears the cached hash code. Needs to be called whenever the knot vectors are modified
+ * \details The function must not be stored in any HashSet while this is done, as it would no longer be found there
+ ***************************************************************************************************************************/
+void Basisfunction::resetHashCode() {
+	hashCode_ = 0;
+}
+
 /************************************************************************************************************************//**
  * \brief Test for B-spline equality
  * \param other The other B-spline to check against
  * \returns True if the knot vectors are identical (up to a tolerance of 1e-10)
  ***************************************************************************************************************************/
 bool Basisfunction::equals(const Basisfunction &other) const {
-	if(knots_.size() != other.knots_.size())
+	if(nVariate_ != other.nVariate_)
 		return false;
-	for(uint i=0; i<knots_.size(); i++) {
-		if(knots_[i].size() != other[i].size())
+	for(int i=0; i<nVariate_; i++) {
+		if((*this)[i].size() != other[i].size())
 			return false;
-		for(uint j=0; j<knots_[i].size(); j++)
-			if(fabs(knots_[i][j] - other[i][j]) > 1e-10)
+		for(uint j=0; j<(*this)[i].size(); j++)
+			if(fabs((*this)[i][j] - other[i][j]) > 1e-10)
 				return false;
 	}
 	return true;
@@ -635,8 +958,8 @@ bool Basisfunction::operator==(const Basisfunction &other) const {
  ***************************************************************************************************************************/
 void Basisfunction::operator+=(const Basisfunction &other) {
 	double newWeight = weight_ + other.weight_;
-	for(uint i=0; i<controlpoint_.size(); i++)
-		controlpoint_[i] = (controlpoint_[i]*weight_ + other.controlpoint_[i]*other.weight_)/newWeight;
+	for(int i=0; i<dim_; i++)
+		cp()[i] = (cp()[i]*weight_ + other.cp()[i]*other.weight_)/newWeight;
 	weight_ = newWeight;
 }
 
@@ -646,14 +969,14 @@ void Basisfunction::operator+=(const Basisfunction &other) {
 Basisfunction* Basisfunction::copy() const {
 
 	std::vector<int> order;
-	for(uint i=0; i<knots_.size(); i++) 
-		order.push_back(knots_[i].size()-1);
-    Basisfunction *returnValue = new Basisfunction(controlpoint_.size(), knots_.size(), order);
+	for(int i=0; i<nVariate_; i++) 
+		order.push_back((*this)[i].size()-1);
+    Basisfunction *returnValue = new Basisfunction(dim_, nVariate_, order);
 
-	for(uint i=0; i<knots_.size(); i++) 
-		std::copy(knots_[i].begin(), knots_[i].end(), returnValue->knots_[i].begin());
+	for(int i=0; i<nVariate_; i++) 
+		std::copy((*this)[i].begin(), (*this)[i].end(), (*returnValue)[i].begin());
 
-	std::copy(controlpoint_.begin(), controlpoint_.end(), returnValue->controlpoint_.begin());
+	std::copy(cp(), cp()+dim_, returnValue->cp());
 	returnValue->weight_ = weight_;
 	returnValue->id_     = id_;
 
@@ -678,18 +1001,18 @@ void Basisfunction::read(std::istream &is) {
 
 	// read knot vectors
 	bool isFirst = true;
-	for(uint i=0; i<knots_.size(); i++) {
+	for(int i=0; i<nVariate_; i++) {
 		if(!isFirst) ASSERT_NEXT_CHAR('x');
 		ASSERT_NEXT_CHAR('[');
-		for(uint j=0; j<knots_[i].size(); j++)
-			is >> knots_[i][j];
+		for(uint j=0; j<(*this)[i].size(); j++)
+			is >> (*this)[i][j];
 		ASSERT_NEXT_CHAR(']');
 		isFirst = false;
 	}
 
 	// read control point
-	for(uint i=0; i<controlpoint_.size(); i++)
-		is >> controlpoint_[i];
+	for(int i=0; i<dim_; i++)
+		is >> cp()[i];
 
 	// read weight
 	ASSERT_NEXT_CHAR('(');
@@ -704,7 +1027,8 @@ void Basisfunction::read(std::istream &is) {
 void Basisfunction::write(std::ostream &os) const {
 	os << id_ << ": ";
 	bool isFirst = true;
-	for(std::vector<double> knot : knots_) {
+	for(int j=0; j<nVariate_; j++) {
+		LocalKnotVector<const double> knot = (*this)[j];
 		if(!isFirst) os << "x ";
 		os << "[";
 		for(uint i=0; i<knot.size(); i++)
@@ -713,8 +1037,8 @@ void Basisfunction::write(std::ostream &os) const {
 		isFirst = false;
 	}
 
-	for(uint i=0; i<controlpoint_.size(); i++)
-		os << controlpoint_[i] << " ";
+	for(int i=0; i<dim_; i++)
+		os << cp()[i] << " ";
 	os << "(" << weight_ << ")";
 }
 
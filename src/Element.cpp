@@ -3,6 +3,7 @@
 #include "LRSpline/Meshline.h"
 #include "LRSpline/Basisfunction.h"
 #include <stdlib.h>
+#include <algorithm>
 
 typedef unsigned int uint;
 
@@ -12,7 +13,8 @@ namespace LR {
  * \brief Default constructor
  ***************************************************************************************************************************/
 Element::Element() {
-	id_      = -1;
+	dim_          = 0;
+	id_           = -1;
 	overloadCount = 0;
 }
 
@@ -21,10 +23,11 @@ Element::Element() {
  * \param dim The dimension of the element (2 for SplineSurfaces, 3 for SplineVolumes)
  ***************************************************************************************************************************/
 Element::Element(int dim) {
+	dim_          = dim;
 	id_           = -1;
 	overloadCount = 0;
-	min.resize(dim);
-	max.resize(dim);
+	std::fill(min, min+dim, 0.0);
+	std::fill(max, max+dim, 0.0);
 }
 
 /************************************************************************************************************************//**
@@ -35,9 +38,7 @@ Element::Element(int dim) {
  * \param stop_v  Upper right v-coordinate
  ***************************************************************************************************************************/
 Element::Element(double start_u, double start_v, double stop_u, double stop_v) {
-	min.resize(2);
-	max.resize(2);
-
+	dim_   = 2;
 	min[0] = start_u;
 	min[1] = start_v;
 	max[0] = stop_u ;
@@ -51,7 +52,9 @@ Element::Element(double start_u, double start_v, double stop_u, double stop_v) {
  * \param f The pointer to the Basisfunction to remove
  ***************************************************************************************************************************/
 void Element::removeSupportFunction(Basisfunction *f) {
-	support_.erase(f);
+	std::vector<Basisfunction*>::iterator it = std::find(support_.begin(), support_.end(), f);
+	if(it != support_.end())
+		support_.erase(it);
 }
 
 /************************************************************************************************************************//**
@@ -59,7 +62,8 @@ void Element::removeSupportFunction(Basisfunction *f) {
  * \param f The pointer to the Basisfunction to add
  ***************************************************************************************************************************/
 void Element::addSupportFunction(Basisfunction *f) {
-	support_.insert(f);
+	if(std::find(support_.begin(), support_.end(), f) == support_.end())
+		support_.push_back(f);
 }
 
 /************************************************************************************************************************//**
@@ -69,9 +73,11 @@ Element* Element::copy() {
 	Element *returnvalue = new Element();
 	
 	returnvalue->id_          = this->id_;
-	returnvalue->min          = this->min;    // it seems that the default vector operator= thing takes a deep copy 
-	returnvalue->max          = this->max;
+	returnvalue->dim_         = this->dim_;
+	std::copy(min, min+dim_, returnvalue->min);
+	std::copy(max, max+dim_, returnvalue->max);
 
+	// store ids, to be resolved by updateBasisPointers()
 	for(Basisfunction* b : support_)
 		returnvalue->support_ids_.push_back(b->getId());
 	
@@ -83,36 +89,40 @@ Element* Element::copy() {
  * \brief Splits an element into two new ones by reducing the size of this element and returning a new element.
  * \param splitDim The constant parameter direction to split the element
  * \param par_value The parameter value to do the splitting
+ * \param pool If given, the new element is created in this pool rather than by new
  * \returns The new element resulting from the splitting
  ***************************************************************************************************************************/
-Element* Element::split(int splitDim, double par_value) {
+Element* Element::split(int splitDim, double par_value, ObjectPool<Element> *pool) {
 	Element *newElement = NULL;
 	if(par_value >= max[splitDim] || par_value <= min[splitDim])
 		return NULL;
 		
-	std::vector<double> newMin(min.begin(), min.end());
-	std::vector<double> newMax(max.begin(), max.end());
+	double newMin[ELEMENT_MAX_DIM];
+	double newMax[ELEMENT_MAX_DIM];
+	std::copy(min, min+dim_, newMin);
+	std::copy(max, max+dim_, newMax);
 
 	newMin[splitDim] = par_value; // new element should start at par_value
 	max[splitDim]    = par_value; // old element should stop  at par_value
 
-	newElement = new Element(min.size(), newMin.begin(), newMax.begin());
-
-	for(Basisfunction *b : support_)
-		if(b->addSupport(newElement)) // tests for overlapping as well
-			newElement->addSupportFunction(b);
-
-	bool someChange = true;
-	while(someChange) {
-		someChange = false;
-		for(Basisfunction *b : support_) {
-			if(!b->overlaps(this)) {
-				support_.erase(b);
-				someChange = true;
-				break;
-			}
+	if(pool != NULL)
+		newElement = new (pool->allocate()) Element(dim_, newMin, newMax);
+	else
+		newElement = new Element(dim_, newMin, newMax);
+
+	// All supported functions overlap the element prior to the split, so the split direction alone decides which half (or
+	// both) they overlap. Partition the support in one pass, keeping the order of the functions in both halves
+	uint nKeep = 0;
+	for(uint i=0; i<support_.size(); i++) {
+		Basisfunction *b = support_[i];
+		if(b->getParmax(splitDim) > par_value) { // continues past the split, has support on the new element
+			b->addSupport(newElement);
+			newElement->support_.push_back(b);
 		}
+		if(b->getParmin(splitDim) < par_value)   // starts before the split, keeps its support on this element
+			support_[nKeep++] = b;
 	}
+	support_.resize(nKeep);
 	return newElement;
 }
 
@@ -123,10 +133,12 @@ Element* Element::split(int splitDim, double par_value) {
 void Element::updateBasisPointers(std::vector<Basisfunction*> &basis) {
 	for(uint i=0; i<support_ids_.size(); i++) {
 		// add pointer from Element to Basisfunction
-		support_.insert(basis[support_ids_[i]]);
+		Basisfunction *b = basis[support_ids_[i]];
+		support_.push_back(b);
 		// add pointer from Basisfunction back to Element
-		basis[support_ids_[i]]->addSupport(this);
+		b->addSupport(this);
 	}
+	std::vector<int>().swap(support_ids_); // release the memory, the ids are not needed anymore
 }
 
 /************************************************************************************************************************//**
@@ -143,8 +155,11 @@ void Element::read(std::istream &is) {
 	is >> dim;
 	ASSERT_NEXT_CHAR(']');
 	ASSERT_NEXT_CHAR(':');
-	min.resize(dim);
-	max.resize(dim);
+	if(dim > ELEMENT_MAX_DIM) {
+		std::cerr << "Error parsing element: dimension " << dim << " not supported\n";
+		exit(327);
+	}
+	dim_ = dim;
 
 	ASSERT_NEXT_CHAR('(');
 	is >> min[0];
@@ -163,8 +178,10 @@ void Element::read(std::istream &is) {
 	ASSERT_NEXT_CHAR(')');
 	ASSERT_NEXT_CHAR('{');
 
-	// read id's of all supported basis functions
+	// read id's of all supported basis functions. These are resolved to pointers by updateBasisPointers()
 	int basis_id;
+	support_.clear();
+	support_ids_.clear();
 	is >> basis_id;
 	support_ids_.push_back(basis_id);
 	ws(is);
@@ -184,12 +201,12 @@ void Element::read(std::istream &is) {
  * \param os The output stream to write to
  ***************************************************************************************************************************/
 void Element::write(std::ostream &os) const {
-	os << id_ << " [" << min.size() << "] : ";
+	os << id_ << " [" << dim_ << "] : ";
 	os << "(" << min[0];
-	for(uint i=1; i<min.size(); i++) 
+	for(int i=1; i<dim_; i++) 
 		os << ", " << min[i] ;
 	os << ") x (" << max[0];
-	for(uint i=1; i<max.size(); i++) 
+	for(int i=1; i<dim_; i++) 
 		os << ", " << max[i] ;
 	os << ")";
 	os << "    {";
@@ -209,8 +226,8 @@ void Element::write(std::ostream &os) const {
  ***************************************************************************************************************************/
 bool Element::isOverloaded()  const {
 	int n = support_.size();
-	Basisfunction *b = *support_.begin();
 	if(n > 0) {
+		Basisfunction *b = support_[0];
 		if(b->nVariate() == 2) { // surfaces
 			int p1 = (*support_.begin())->getOrder(0);
 			int p2 = (*support_.begin())->getOrder(1);
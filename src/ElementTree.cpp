@@ -0,0 +1,291 @@
+#include "LRSpline/ElementTree.h"
+#include "LRSpline/Element.h"
+#include "LRSpline/Profiler.h"
+#include <algorithm>
+
+typedef unsigned int uint;
+
+namespace LR {
+
+#define MAX_TREE_DEPTH        30
+#define MAX_NODES_PER_ELEMENT 32
+
+/************************************************************************************************************************//**
+ * \brief Default constructor. Creates an empty (unbuilt) tree
+ ***************************************************************************************************************************/
+ElementTree::ElementTree() {
+	dim_          = 0;
+	leafCapacity_ = 0;
+}
+
+/************************************************************************************************************************//**
+ * \brief Removes all nodes from the tree. It has to be rebuilt before being used again
+ ***************************************************************************************************************************/
+void ElementTree::clear() {
+	nodes_.clear();
+}
+
+/************************************************************************************************************************//**
+ * \brief Builds the tree from scratch, discarding any previous content
+ * \param elements The elements to index. The tree stores the indices into this vector
+ * \param start The parametric start coordinate of the domain
+ * \param end The parametric stop coordinate of the domain
+ ***************************************************************************************************************************/
+void ElementTree::build(const std::vector<Element*> &elements, const std::vector<double> &start, const std::vector<double> &end) {
+#ifdef TIME_LRSPLINE
+	PROFILE("build element tree");
+#endif
+	start_        = start;
+	end_          = end;
+	dim_          = start.size();
+	leafCapacity_ = 2 << dim_; // at most 2^dim elements meet at any point, so leaves can always be split below capacity
+	nodes_.clear();
+	nodes_.resize(1);
+	nodes_[0].child = -1;
+
+	double lo[3], hi[3];
+	for(uint i=0; i<elements.size(); i++) {
+		for(int d=0; d<dim_; d++) {
+			lo[d] = start_[d];
+			hi[d] = end_[d];
+		}
+		insert(elements, i, 0, lo, hi, 0);
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Inserts one element in all leaves below node which it overlaps, subdividing leaves which become overfull
+ * \param elements The element list which the tree is built over
+ * \param iEl The index of the element to insert
+ * \param node The index of the node to insert into
+ * \param lo The lower left corner of node
+ * \param hi The upper right corner of node
+ * \param depth The depth of node in the tree (root is at zero depth)
+ ***************************************************************************************************************************/
+void ElementTree::insert(const std::vector<Element*> &elements, int iEl, int node, double *lo, double *hi, int depth) {
+	const Element *el = elements[iEl];
+	// only keep elements with a nonzero overlap with this node
+	for(int d=0; d<dim_; d++)
+		if(el->getParmin(d) >= hi[d] || el->getParmax(d) <= lo[d])
+			return;
+
+	if(nodes_[node].child == -1) {
+		nodes_[node].elements.push_back(iEl);
+		if(nodes_[node].elements.size() <= (uint) leafCapacity_ || depth >= MAX_TREE_DEPTH)
+			return;
+		// overlapping (i.e. corrupt) elements would cause endless subdivision, so bound the tree size by the element count
+		if(nodes_.size() > MAX_NODES_PER_ELEMENT * elements.size())
+			return;
+
+		// leaf is full: create 2^dim children and distribute its elements among them
+		int firstChild = nodes_.size();
+		nodes_.resize(firstChild + (1<<dim_));
+		for(int c=0; c<(1<<dim_); c++)
+			nodes_[firstChild+c].child = -1;
+		std::vector<int> moved;
+		moved.swap(nodes_[node].elements);
+		nodes_[node].child = firstChild;
+		for(uint i=0; i<moved.size(); i++)
+			insert(elements, moved[i], node, lo, hi, depth);
+		return;
+	}
+
+	double childLo[3], childHi[3];
+	for(int c=0; c<(1<<dim_); c++) {
+		for(int d=0; d<dim_; d++) {
+			double mid = (lo[d] + hi[d]) / 2;
+			childLo[d] = ((c>>d)&1) ? mid   : lo[d];
+			childHi[d] = ((c>>d)&1) ? hi[d] : mid;
+		}
+		insert(elements, iEl, nodes_[node].child + c, childLo, childHi, depth+1);
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Removes one element from all leaves below node which it overlaps
+ * \param elements The element list which the tree is built over
+ * \param iEl The index of the element to remove
+ * \param node The index of the node to remove from
+ * \param lo The lower left corner of node
+ * \param hi The upper right corner of node
+ ***************************************************************************************************************************/
+void ElementTree::remove(const std::vector<Element*> &elements, int iEl, int node, double *lo, double *hi) {
+	const Element *el = elements[iEl];
+	for(int d=0; d<dim_; d++)
+		if(el->getParmin(d) >= hi[d] || el->getParmax(d) <= lo[d])
+			return;
+
+	if(nodes_[node].child == -1) {
+		std::vector<int> &list = nodes_[node].elements;
+		std::vector<int>::iterator it = std::find(list.begin(), list.end(), iEl);
+		if(it != list.end())
+			list.erase(it);
+		return;
+	}
+
+	double childLo[3], childHi[3];
+	for(int c=0; c<(1<<dim_); c++) {
+		for(int d=0; d<dim_; d++) {
+			double mid = (lo[d] + hi[d]) / 2;
+			childLo[d] = ((c>>d)&1) ? mid   : lo[d];
+			childHi[d] = ((c>>d)&1) ? hi[d] : mid;
+		}
+		remove(elements, iEl, nodes_[node].child + c, childLo, childHi);
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Adds one element to the tree. Does nothing if the tree is not built
+ * \param elements The element list which the tree is built over
+ * \param iEl The index of the element to add
+ * \details Typically called on both halves after an Element::split(), with the old element removed by removeElement()
+ *          prior to the split
+ ***************************************************************************************************************************/
+void ElementTree::addElement(const std::vector<Element*> &elements, int iEl) {
+	if(!isBuilt())
+		return;
+	double lo[3], hi[3];
+	for(int d=0; d<dim_; d++) {
+		lo[d] = start_[d];
+		hi[d] = end_[d];
+	}
+	insert(elements, iEl, 0, lo, hi, 0);
+}
+
+/************************************************************************************************************************//**
+ * \brief Removes one element from the tree. Does nothing if the tree is not built
+ * \param elements The element list which the tree is built over
+ * \param iEl The index of the element to remove
+ * \details The element must have the same parametric extent as it had when it was added to the tree
+ ***************************************************************************************************************************/
+void ElementTree::removeElement(const std::vector<Element*> &elements, int iEl) {
+	if(!isBuilt())
+		return;
+	double lo[3], hi[3];
+	for(int d=0; d<dim_; d++) {
+		lo[d] = start_[d];
+		hi[d] = end_[d];
+	}
+	remove(elements, iEl, 0, lo, hi);
+}
+
+/************************************************************************************************************************//**
+ * \brief Checks if a parametric point is contained in an element
+ * \param el The element to test
+ * \param par The parametric point
+ * \details Elements are treated as half-open boxes [min,max), except for the upper domain boundary which is included in
+ *          the elements touching it
+ ***************************************************************************************************************************/
+bool ElementTree::contains(const Element *el, const double *par) const {
+	for(int d=0; d<dim_; d++) {
+		if(par[d] < el->getParmin(d))
+			return false;
+		if(!(par[d] < el->getParmax(d) || (par[d] == end_[d] && par[d] <= el->getParmax(d))))
+			return false;
+	}
+	return true;
+}
+
+/************************************************************************************************************************//**
+ * \brief Get the index of the element containing a parametric point
+ * \param elements The element list which the tree was built over
+ * \param par The parametric point (2 components for surfaces, 3 for volumes)
+ * \return The index of the element which contains par, or -1 if none is found
+ * \details Descends down to the leaf containing par and tests only the elements stored there. The complexity is
+ *          O(log n) for n elements
+ ***************************************************************************************************************************/
+int ElementTree::getElementContaining(const std::vector<Element*> &elements, const double *par) const {
+	for(int d=0; d<dim_; d++)
+		if(par[d] < start_[d] || par[d] > end_[d])
+			return -1;
+
+	double lo[3], hi[3];
+	for(int d=0; d<dim_; d++) {
+		lo[d] = start_[d];
+		hi[d] = end_[d];
+	}
+	int node = 0;
+	while(nodes_[node].child != -1) {
+		int c = 0;
+		for(int d=0; d<dim_; d++) {
+			double mid = (lo[d] + hi[d]) / 2;
+			if(par[d] >= mid) {
+				c |= (1<<d);
+				lo[d] = mid;
+			} else {
+				hi[d] = mid;
+			}
+		}
+		node = nodes_[node].child + c;
+	}
+
+	for(int i : nodes_[node].elements)
+		if(contains(elements[i], par))
+			return i;
+	return -1;
+}
+
+/************************************************************************************************************************//**
+ * \brief Gathers the elements stored in all leaves below node which overlap the box [lo,hi]
+ * \param elements The element list which the tree was built over
+ * \param lo The lower left corner of the query box
+ * \param hi The upper right corner of the query box
+ * \param node The index of the node to search
+ * \param nodeLo The lower left corner of node
+ * \param nodeHi The upper right corner of node
+ * \param result [out] Indices of the overlapping elements, possibly with duplicates
+ ***************************************************************************************************************************/
+void ElementTree::collect(const std::vector<Element*> &elements, const double *lo, const double *hi, int node, double *nodeLo, double *nodeHi, std::vector<int> &result) const {
+	for(int d=0; d<dim_; d++)
+		if(lo[d] > nodeHi[d] || hi[d] < nodeLo[d])
+			return;
+
+	if(nodes_[node].child == -1) {
+		for(int i : nodes_[node].elements) {
+			const Element *el = elements[i];
+			bool overlaps = true;
+			for(int d=0; d<dim_ && overlaps; d++)
+				overlaps = el->getParmin(d) <= hi[d] && el->getParmax(d) >= lo[d];
+			if(overlaps)
+				result.push_back(i);
+		}
+		return;
+	}
+
+	double childLo[3], childHi[3];
+	for(int c=0; c<(1<<dim_); c++) {
+		for(int d=0; d<dim_; d++) {
+			double mid = (nodeLo[d] + nodeHi[d]) / 2;
+			childLo[d] = ((c>>d)&1) ? mid       : nodeLo[d];
+			childHi[d] = ((c>>d)&1) ? nodeHi[d] : mid;
+		}
+		collect(elements, lo, hi, nodes_[node].child + c, childLo, childHi, result);
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Get the indices of all elements overlapping a box
+ * \param elements The element list which the tree was built over
+ * \param lo The lower left corner of the query box (2 components for surfaces, 3 for volumes)
+ * \param hi The upper right corner of the query box
+ * \param result [out] The indices of all elements whose closed extent intersects the closed box [lo,hi], in increasing order
+ * \details The box may be degenerate (i.e. lo[d]==hi[d]), in which case all elements touching this plane are found. Only
+ *          the leaves overlapping the box are visited, so the complexity is O(log n + k) for k overlapping elements
+ ***************************************************************************************************************************/
+void ElementTree::getElementsOverlapping(const std::vector<Element*> &elements, const double *lo, const double *hi, std::vector<int> &result) const {
+	result.clear();
+	if(!isBuilt())
+		return;
+	double nodeLo[3], nodeHi[3];
+	for(int d=0; d<dim_; d++) {
+		nodeLo[d] = start_[d];
+		nodeHi[d] = end_[d];
+	}
+	collect(elements, lo, hi, 0, nodeLo, nodeHi, result);
+	// elements spanning several leaves are found multiple times
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+} // end namespace LR
+
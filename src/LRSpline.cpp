@@ -1,15 +1,21 @@
 #include "LRSpline/LRSpline.h"
 #include "LRSpline/Basisfunction.h"
 #include "LRSpline/Element.h"
+#include "LRSpline/Profiler.h"
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+#include <cfloat>
 
 typedef unsigned int uint;
 
 namespace LR {
 
 LRSpline::LRSpline() {
-	dim_      = 0;
+	dim_               = 0;
+	basisIndexVersion_ = basis_.version();
+	allElementsDirty_  = true;
 	element_.resize(0);
-	lastElementEvaluation = 0;
 }
 
 void LRSpline::generateIDs() const {
@@ -18,6 +24,141 @@ void LRSpline::generateIDs() const {
 		b->setId(i++);
 	for(i=0; i<element_.size(); i++) 
 		element_[i]->setId(i);
+	buildBasisIndex();
+}
+
+/************************************************************************************************************************//**
+ * \brief Stores all basis functions in iteration order for constant time lookup by getBasisfunction()
+ ***************************************************************************************************************************/
+void LRSpline::buildBasisIndex() const {
+	basisIndex_.assign(basis_.begin(), basis_.end());
+	basisIndexVersion_ = basis_.version();
+}
+
+/************************************************************************************************************************//**
+ * \brief Get all basis functions whose support overlaps a box, using the element tree
+ * \param lo The lower left corner of the box (2 components for surfaces, 3 for volumes)
+ * \param hi The upper right corner of the box
+ * \param functions [out] The supported functions of all elements touching [lo,hi], each listed once in no particular order
+ * \returns false if the element tree is not built, in which case functions is left empty and the caller has to search
+ *          through all of basis_
+ * \details Any function with some part of its support in [lo,hi] has an element there, so this finds all candidates for
+ *          refinement by a meshline (or mesh rectangle) while only visiting the elements near it
+ ***************************************************************************************************************************/
+bool LRSpline::getBasisfunctionsOverlapping(const double *lo, const double *hi, std::vector<Basisfunction*> &functions) const {
+	functions.clear();
+	if(!elementTree_.isBuilt())
+		return false;
+	std::vector<int> elements;
+	elementTree_.getElementsOverlapping(element_, lo, hi, elements);
+	for(int i : elements)
+		functions.insert(functions.end(), element_[i]->constSupportBegin(), element_[i]->constSupportEnd());
+	std::sort(functions.begin(), functions.end());
+	functions.erase(std::unique(functions.begin(), functions.end()), functions.end());
+	return true;
+}
+
+/************************************************************************************************************************//**
+ * \brief Used by refineByDimensionIncrease(), finds the entries whose refinement lines may change by inserting some lines
+ * \param lo The lower corner of a box around the lines (or mesh rectangles) to insert, widened by the tolerance. Overwritten
+ * \param hi The upper corner of the box. Overwritten
+ * \param rank Element index (or function index for the structured mesh) to position in the sorted error list
+ * \param functionIndex Pairs of function pointer and function index, sorted by pointer (structured mesh only)
+ * \param generated For each position in the error list, true if the lines of that entry have been generated
+ * \param work [in,out] The number of functions and elements visited by all calls so far
+ * \param pending [out] The positions of all affected entries which are not yet generated are appended to this list
+ * \details The lines of an element only depend on the extent of the element and of its supported functions (minspan and
+ *          fullspan), and the lines of a function only on its knots (structured mesh). Inserting lines splits the functions
+ *          and elements crossing them, all of which overlap the box, and the new functions lie within the support of the
+ *          function they were split from (functions they are added to keep their knots). Where a line is merged with an
+ *          existing one, the functions crossing only the old part already have the knot and are not split. Hence the
+ *          functions which may be split are among those overlapping the box, and the elements whose extent or support may
+ *          change are among those overlapping the union of the supports of these. Elements appended by the splitting have no
+ *          error and are not entries. If there is no element tree, or the lookups have visited more objects than there are
+ *          entries in total, all entries not yet generated are reported instead, which is always safe
+ ***************************************************************************************************************************/
+void LRSpline::addAffectedEntries(double *lo, double *hi, const std::vector<int> &rank,
+                                  const std::vector<std::pair<Basisfunction*,int> > &functionIndex,
+                                  const std::vector<bool> &generated, size_t &work, std::vector<int> &pending) const {
+	std::vector<Basisfunction*> nearFunctions;
+	if(work > generated.size() || !getBasisfunctionsOverlapping(lo, hi, nearFunctions)) {
+		for(uint j=0; j<generated.size(); j++)
+			if(!generated[j])
+				pending.push_back(j);
+		return;
+	}
+	work += nearFunctions.size();
+	if(refStrat_ == LR_STRUCTURED_MESH) {
+		for(Basisfunction *b : nearFunctions) {
+			std::vector<std::pair<Basisfunction*,int> >::const_iterator it;
+			it = std::lower_bound(functionIndex.begin(), functionIndex.end(), std::make_pair(b, 0));
+			if(it != functionIndex.end() && it->first == b && !generated[rank[it->second]])
+				pending.push_back(rank[it->second]);
+		}
+	} else if(!nearFunctions.empty()) {
+		// the supports of all elements covered by these functions may change
+		int dim = nVariate();
+		for(int d=0; d<dim; d++) {
+			lo[d] =  DBL_MAX;
+			hi[d] = -DBL_MAX;
+		}
+		for(Basisfunction *b : nearFunctions) {
+			for(int d=0; d<dim; d++) {
+				lo[d] = std::min(lo[d], b->getParmin(d));
+				hi[d] = std::max(hi[d], b->getParmax(d));
+			}
+		}
+		std::vector<int> nearElements;
+		elementTree_.getElementsOverlapping(element_, lo, hi, nearElements);
+		work += nearElements.size();
+		for(int j : nearElements)
+			if(j < (int) rank.size() && !generated[rank[j]]) // elements created by this refinement have no error
+				pending.push_back(rank[j]);
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Sorts a list of basis functions in the iteration order of basis_
+ * \param functions The functions to sort. All of them must be in basis_
+ * \details Refinement visits functions in this order, which decides the order of the new functions and thus their ids
+ ***************************************************************************************************************************/
+void LRSpline::sortInBasisOrder(std::vector<Basisfunction*> &functions) const {
+	std::vector<std::pair<long, Basisfunction*> > position(functions.size());
+	for(uint i=0; i<functions.size(); i++)
+		position[i] = std::make_pair(basis_.indexOf(functions[i]), functions[i]);
+	std::sort(position.begin(), position.end());
+	for(uint i=0; i<functions.size(); i++)
+		functions[i] = position[i].second;
+}
+
+/************************************************************************************************************************//**
+ * \brief Get a basis function by its position in the iteration order of basis_ (which is its id after generateIDs())
+ * \param iBasis The index of the basis function
+ * \returns The basis function, or NULL if iBasis is out of range
+ * \details Constant time. Refinement changes the basis, in which case the index is rebuilt on the first call
+ ***************************************************************************************************************************/
+Basisfunction* LRSpline::getBasisfunction(int iBasis) {
+	if(iBasis<0 || iBasis>=basis_.size())
+		return NULL;
+	if(basisIndexVersion_ != basis_.version())
+		buildBasisIndex();
+	return basisIndex_[iBasis];
+}
+
+/************************************************************************************************************************//**
+ * \brief Get a basis function by its position in the iteration order of basis_ (which is its id after generateIDs())
+ * \param iBasis The index of the basis function
+ * \returns The basis function, or NULL if iBasis is out of range
+ * \details Constant time. Refinement changes the basis, in which case the index is rebuilt on the first call. The index is a
+ *          cache and not part of the observable state, so this is done here as well, which means that concurrent calls on
+ *          the same spline are not safe after the basis has changed
+ ***************************************************************************************************************************/
+const Basisfunction* LRSpline::getBasisfunction(int iBasis) const {
+	if(iBasis<0 || iBasis>=basis_.size())
+		return NULL;
+	if(basisIndexVersion_ != basis_.version())
+		buildBasisIndex();
+	return basisIndex_[iBasis];
 }
 
 void LRSpline::getEdgeFunctions(std::vector<Basisfunction*> &edgeFunctions, parameterEdge edge, int depth) const {
@@ -78,6 +219,178 @@ void LRSpline::getEdgeElements( std::vector<Element*> &edgeElements, parameterEd
 	}
 }
 
+/************************************************************************************************************************//**
+ * \brief Computes and stores the Bezier extraction operator of every element
+ * \details Once cached, computeBasis() on a given element evaluates the Bernstein basis of the element and multiplies it
+ *          with the extraction operator instead of running the Cox-de Boor recursion for every supported function. This pays
+ *          off when the same elements are evaluated many times, i.e. in quadrature loops. Any refinement discards the cache,
+ *          so this must be called again after the mesh is changed
+ ***************************************************************************************************************************/
+void LRSpline::cacheBezierExtraction() {
+#ifdef TIME_LRSPLINE
+	PROFILE("cacheBezierExtraction()");
+#endif
+	bezierExtraction_.resize(element_.size());
+	for(uint i=0; i<element_.size(); i++)
+		getBezierExtraction(i, bezierExtraction_[i]);
+}
+
+/************************************************************************************************************************//**
+ * \brief Evaluates all univariate Bernstein polynomials and their derivatives on the interval [a,b]
+ * \param result [out] Derivative d of Bernstein polynomial i is stored at result[d*order+i]. Must hold order*(derivs+1) values
+ * \param order The polynomial order (degree + 1), i.e. the number of Bernstein polynomials
+ * \param a The interval start
+ * \param b The interval end
+ * \param x The evaluation point
+ * \param derivs The number of derivatives requested
+ ***************************************************************************************************************************/
+void LRSpline::getBernsteinBasis(double *result, int order, double a, double b, double x, int derivs) {
+	int    n = order-1;
+	double t = (x-a)/(b-a);
+	std::fill(result, result + order*(derivs+1), 0.0);
+
+	// raise the degree m one step at a time, and store the basis of degree n-d as the starting point for derivative d
+	std::vector<double> row(order);
+	row[0] = 1.0;
+	for(int m=0; m<=n; m++) {
+		if(m > 0) {
+			row[m] = t*row[m-1];
+			for(int i=m-1; i>0; i--)
+				row[i] = (1-t)*row[i] + t*row[i-1];
+			row[0] = (1-t)*row[0];
+		}
+		int d = n-m;
+		if(d > derivs)
+			continue;
+		double *res = result + d*order;
+		std::copy(row.begin(), row.begin()+m+1, res);
+		// differentiate d times: d/dx B(i,k) = k/(b-a) * (B(i-1,k-1) - B(i,k-1))
+		for(int k=m+1; k<=n; k++)
+			for(int i=k; i>=0; i--)
+				res[i] = k/(b-a) * ( ((i>0) ? res[i-1] : 0.0) - ((i<k) ? res[i] : 0.0) );
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Adds a quadrature rule and caches all basis functions evaluated at its points on every element
+ * \param points The reference points in [-1,1] for each parametric direction. The quadrature points are the tensor grid of
+ *               these, mapped to each element
+ * \param derivs The number of derivatives to cache
+ * \return The index of the rule, used to look up values through getQuadratureBasis()
+ * \details Intended for finite element assembly where the same Gauss points are evaluated on all elements in every pass.
+ *          Refinement only marks the elements it changes as stale, and updateQuadratureCache() recomputes these
+ ***************************************************************************************************************************/
+int LRSpline::addQuadratureRule(const std::vector<std::vector<double> > &points, int derivs) {
+	if((int) points.size() != nVariate()) {
+		std::cerr << "Error LRSpline::addQuadratureRule(...) parametric dimension mismatch" << std::endl;
+		exit(9240);
+	}
+	quadrature_.resize(quadrature_.size()+1);
+	quadrature_.back().points = points;
+	quadrature_.back().derivs = derivs;
+	updateQuadratureCache();
+	return quadrature_.size()-1;
+}
+
+/************************************************************************************************************************//**
+ * \brief Recomputes the cached quadrature values of all stale elements, i.e. the ones changed by refinement since last update
+ * \details The values of the remaining elements are kept, and the arena is compacted in the process. This invalidates any
+ *          pointers previously returned by getQuadratureBasis()
+ ***************************************************************************************************************************/
+void LRSpline::updateQuadratureCache() {
+#ifdef TIME_LRSPLINE
+	PROFILE("updateQuadratureCache()");
+#endif
+	int dim = nVariate();
+	for(QuadratureCache &cache : quadrature_) {
+		bool stale = cache.offset.size() != element_.size();
+		for(uint i=0; i<cache.offset.size() && !stale; i++)
+			stale = (cache.offset[i] < 0);
+		if(!stale)
+			continue;
+
+		int nQ = 1;
+		for(int d=0; d<dim; d++)
+			nQ *= cache.points[d].size();
+		int derivs  = cache.derivs;
+		int nDerivs = (dim == 2) ? (derivs+1)*(derivs+2)/2 : (derivs+1)*(derivs+2)*(2*derivs+6)/12;
+
+		std::vector<double> arena;
+		std::vector<int>    offset(element_.size());
+		uint size = 0;
+		for(uint iEl=0; iEl<element_.size(); iEl++)
+			size += nQ * element_[iEl]->nBasisFunctions() * nDerivs;
+		arena.resize(size);
+
+		std::vector<const Basisfunction*> functions;
+		int start = 0;
+		for(uint iEl=0; iEl<element_.size(); iEl++) {
+			const Element *el = element_[iEl];
+			int nValues = nQ * el->nBasisFunctions() * nDerivs;
+			offset[iEl] = start;
+			if(iEl < cache.offset.size() && cache.offset[iEl] >= 0) {
+				std::copy(cache.arena.begin() + cache.offset[iEl], cache.arena.begin() + cache.offset[iEl] + nValues, arena.begin() + start);
+			} else {
+				functions.assign(el->constSupportBegin(), el->constSupportEnd());
+				for(int q=0; q<nQ; q++) {
+					double parPt[3];
+					bool   fromRight[3];
+					int    index = q;
+					for(int d=0; d<dim; d++) {
+						int n        = cache.points[d].size();
+						double xi    = cache.points[d][index % n];
+						index       /= n;
+						parPt[d]     = el->getParmin(d) + (xi+1)/2*(el->getParmax(d) - el->getParmin(d));
+						fromRight[d] = parPt[d] != end_[d];
+					}
+					Basisfunction::evaluate(arena.data() + start + q*functions.size()*nDerivs, functions.data(), functions.size(), parPt, derivs, fromRight);
+				}
+			}
+			start += nValues;
+		}
+		cache.arena.swap(arena);
+		cache.offset.swap(offset);
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Get the cached basis function values on one element
+ * \param iEl The element index
+ * \param rule The quadrature rule index, as returned by addQuadratureRule()
+ * \return Pointer into the cache, or NULL if the element is stale (call updateQuadratureCache() after refinement)
+ * \details Derivative k of support function i at quadrature point q is found at [(q*n + i)*nDerivs + k], where n is the
+ *          number of support functions on the element, and nDerivs and the derivative ordering are as in computeBasis().
+ *          The quadrature points are ordered with the first parametric direction running fastest, and the functions in
+ *          the same order as Element::support(). The values are valid until the next call to updateQuadratureCache()
+ ***************************************************************************************************************************/
+const double* LRSpline::getQuadratureBasis(int iEl, int rule) const {
+	if(rule < 0 || rule >= (int) quadrature_.size())
+		return NULL;
+	const QuadratureCache &cache = quadrature_[rule];
+	if(iEl < 0 || iEl >= (int) cache.offset.size() || cache.offset[iEl] < 0)
+		return NULL;
+	return &cache.arena[cache.offset[iEl]];
+}
+
+/************************************************************************************************************************//**
+ * \brief Marks all elements in all quadrature rules as stale
+ ***************************************************************************************************************************/
+void LRSpline::invalidateQuadratureCache() {
+	for(QuadratureCache &cache : quadrature_)
+		cache.offset.clear();
+}
+
+/************************************************************************************************************************//**
+ * \brief Marks some elements in all quadrature rules as stale
+ * \param touched The elements which have changed (elements added to the end of the element list are always stale)
+ ***************************************************************************************************************************/
+void LRSpline::invalidateQuadratureCache(const std::set<const Element*> &touched) {
+	for(QuadratureCache &cache : quadrature_)
+		for(uint i=0; i<cache.offset.size(); i++)
+			if(touched.count(element_[i]))
+				cache.offset[i] = -1;
+}
+
 bool LRSpline::setControlPoints(std::vector<double>& controlpoints) {
 	if((int) controlpoints.size() != dim_*basis_.size())
 		return false;
@@ -86,7 +399,7 @@ bool LRSpline::setControlPoints(std::vector<double>& controlpoints) {
 
 	HashSet_iterator<Basisfunction*> bit;
 	for(bit=basis_.begin(); bit!=basis_.end(); ++bit) {
-		std::vector<double>::iterator cp = (**bit).cp();
+		double *cp = (**bit).cp();
 		for(int i=0; i<dim_; i++, cp++, newCP++)
 			*cp = *newCP;
 	}
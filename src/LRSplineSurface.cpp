@@ -159,6 +159,7 @@ void LRSplineSurface::initMeta() {
 	refStrat_             = LR_FULLSPAN;
 	refKnotlineMult_      = 1;
 	symmetry_             = 1;
+	nRemovedMeshlines_    = 0;
 	element_red           = 0.5;
 	element_green         = 0.5;
 	element_blue          = 0.5;
@@ -177,11 +178,12 @@ void LRSplineSurface::initMeta() {
  ***************************************************************************************************************************/
 LRSplineSurface::~LRSplineSurface() {
 	for(Basisfunction* b : basis_)
-		delete b;
+		basisPool_.destroy(b);
 	for(uint i=0; i<meshline_.size(); i++)
-		delete meshline_[i];
+		if(meshline_[i] != NULL) // removed by insert_line(), see compactMeshlines()
+			meshlinePool_.destroy(meshline_[i]);
 	for(uint i=0; i<element_.size(); i++)
-		delete element_[i];
+		elementPool_.destroy(element_[i]);
 }
 
 
@@ -190,6 +192,7 @@ LRSplineSurface::~LRSplineSurface() {
  * \returns A deep copy, where all Basisfunction, Element and Meshline are also copied
  ***************************************************************************************************************************/
 LRSplineSurface* LRSplineSurface::copy() const {
+	compactMeshlines();
 	generateIDs();
 
 	std::vector<Basisfunction*> basisVector;
@@ -211,6 +214,7 @@ LRSplineSurface* LRSplineSurface::copy() const {
 	
 	for(Meshline *m : meshline_)
 		returnvalue -> meshline_.push_back(m->copy());
+	returnvalue -> buildMeshlineIndex();
 	
 	returnvalue->rational_         = this->rational_;
 	returnvalue->dim_              = this->dim_;
@@ -220,6 +224,7 @@ LRSplineSurface* LRSplineSurface::copy() const {
 	returnvalue->start_[1]          = this->start_[1];
 	returnvalue->end_[0]            = this->end_[0];
 	returnvalue->end_[1]            = this->end_[1];
+	returnvalue->elementTree_.build(returnvalue->element_, returnvalue->start_, returnvalue->end_);
 	returnvalue->maxTjoints_       = this->maxTjoints_;
 	returnvalue->doCloseGaps_      = this->doCloseGaps_;
 	returnvalue->doAspectRatioFix_ = this->doAspectRatioFix_;
@@ -389,11 +394,77 @@ void LRSplineSurface::point(std::vector<std::vector<double> > &pts, double u, do
 		iEl = getElementContaining(u,v);
 	if(iEl == -1)
 		return;
-	for(Basisfunction* b : element_[iEl]->support() ) {
-		b->evaluate(basis_ev, u,v, derivs, u_from_right, v_from_right);
-		for(uint i=0; i<pts.size(); i++)
+	std::vector<const Basisfunction*> functions(element_[iEl]->constSupportBegin(), element_[iEl]->constSupportEnd());
+	if(functions.empty())
+		return;
+	double parPt[]     = {u, v};
+	bool   fromRight[] = {u_from_right, v_from_right};
+	int    nDerivs     = pts.size();
+	basis_ev.resize(functions.size()*nDerivs);
+	Basisfunction::evaluate(basis_ev.data(), functions.data(), functions.size(), parPt, derivs, fromRight);
+	for(uint k=0; k<functions.size(); k++)
+		for(int i=0; i<nDerivs; i++)
 			for(int j=0; j<dim_; j++)
-				pts[i][j] += basis_ev[i]*b->cp(j);
+				pts[i][j] += basis_ev[k*nDerivs+i]*functions[k]->cp(j);
+}
+
+/************************************************************************************************************************//**
+ * \brief Evaluate the surface and its derivatives at a batch of points
+ * \param nPts The number of points to evaluate
+ * \param upar The u-coordinates of all points (nPts values)
+ * \param vpar The v-coordinates of all points (nPts values)
+ * \param[out] result Caller-allocated buffer of nPts*(derivs+1)*(derivs+2)/2*dimension() values
+ * \param derivs The number of derivatives requested
+ * \details Gives the same values as point() for each individual point, but the points are grouped by their containing
+ *          element internally such that the element lookup and support function list is reused for all points on the
+ *          same element, and no memory is allocated per point. The result is stored point by point, then derivative by
+ *          derivative (same order as point()), and finally component by component, i.e. derivative k of component j for
+ *          point i is stored at result[(i*nDerivs + k)*dimension() + j]. Points outside the parametric domain are set to zero
+ ***************************************************************************************************************************/
+void LRSplineSurface::points(int nPts, const double *upar, const double *vpar, double *result, int derivs) const {
+#ifdef TIME_LRSPLINE
+	PROFILE("points()");
+#endif
+	int nDerivs = (derivs+1)*(derivs+2)/2;
+	std::fill(result, result + nPts*nDerivs*dim_, 0.0);
+
+	// locate all points and sort them by element (points outside the domain are dropped here)
+	std::vector<std::pair<int,int> > elementPoint;
+	elementPoint.reserve(nPts);
+	int iEl = -1;
+	for(int i=0; i<nPts; i++) {
+		if(upar[i] < start_[0] || end_[0] < upar[i] || 
+		   vpar[i] < start_[1] || end_[1] < vpar[i])
+			continue;
+		iEl = getElementContaining(upar[i], vpar[i], iEl);
+		if(iEl != -1)
+			elementPoint.push_back(std::make_pair(iEl, i));
+	}
+	std::sort(elementPoint.begin(), elementPoint.end());
+
+	std::vector<const Basisfunction*> functions;
+	std::vector<double>               basis_ev;
+	uint k = 0;
+	while(k < elementPoint.size()) {
+		iEl = elementPoint[k].first;
+		functions.assign(element_[iEl]->constSupportBegin(), element_[iEl]->constSupportEnd());
+		basis_ev.resize(functions.size()*nDerivs);
+		if(functions.empty()) { // nothing to add, the points stay zero
+			while(k<elementPoint.size() && elementPoint[k].first == iEl)
+				k++;
+			continue;
+		}
+		for( ; k<elementPoint.size() && elementPoint[k].first == iEl; k++) {
+			int    i           = elementPoint[k].second;
+			double parPt[]     = {upar[i], vpar[i]};
+			bool   fromRight[] = {upar[i]!=end_[0], vpar[i]!=end_[1]};
+			double *pt         = result + i*nDerivs*dim_;
+			Basisfunction::evaluate(basis_ev.data(), functions.data(), functions.size(), parPt, derivs, fromRight);
+			for(uint f=0; f<functions.size(); f++)
+				for(int d=0; d<nDerivs; d++)
+					for(int j=0; j<dim_; j++)
+						pt[d*dim_+j] += basis_ev[f*nDerivs+d]*functions[f]->cp(j);
+		}
 	}
 }
 
@@ -412,18 +483,20 @@ void LRSplineSurface::computeBasis (double param_u, double param_v, Go::BasisDer
 #ifdef TIME_LRSPLINE
 	PROFILE("computeBasis()");
 #endif
-	std::vector<double> values;
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	double values[6];
+	double parPt[]     = {param_u, param_v};
+	bool   fromRight[] = {param_u!=end_[0], param_v!=end_[1]};
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
 	result.prepareDerivs(param_u, param_v, 0, -1, nPts);
 
-	int i=0;
 	//element_[i]->write(std::cout);
 	
-	for(it=itStart; it!=itStop; ++it, ++i) {
-		(*it)->evaluate(values, param_u, param_v, 2, param_u!=end_[0], param_v!=end_[1]);
+	for(int i=0; i<nPts; i++) {
+		functions[i]->evaluate(values, parPt, 2, fromRight);
 	
 		result.basisValues[i]    = values[0];
 		result.basisDerivs_u[i]  = values[1];
@@ -448,16 +521,18 @@ void LRSplineSurface::computeBasis (double param_u, double param_v, Go::BasisDer
 #ifdef TIME_LRSPLINE
 	PROFILE("computeBasis()");
 #endif
-	std::vector<double> values;
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	double values[3];
+	double parPt[]     = {param_u, param_v};
+	bool   fromRight[] = {param_u!=end_[0], param_v!=end_[1]};
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
 	result.prepareDerivs(param_u, param_v, 0, -1, nPts);
 	
-	int i=0;
-	for(it=itStart; it!=itStop; ++it, ++i) {
-		(*it)->evaluate(values, param_u, param_v, 1, param_u!=end_[0], param_v!=end_[1]);
+	for(int i=0; i<nPts; i++) {
+		functions[i]->evaluate(values, parPt, 1, fromRight);
 		
 		result.basisValues[i]   = values[0];
 		result.basisDerivs_u[i] = values[1];
@@ -479,15 +554,15 @@ void LRSplineSurface::computeBasis(double param_u, double param_v, Go::BasisPtsS
 #ifdef TIME_LRSPLINE
 	PROFILE("computeBasis()");
 #endif
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
 
 	result.preparePts(param_u, param_v, 0, -1, nPts);
-	int i=0;
-	for(it=itStart; it!=itStop; ++it, ++i)
-		result.basisValues[i] = (*it)->evaluate(param_u, param_v, param_u!=end_[0], param_v!=end_[1]);
+	for(int i=0; i<nPts; i++)
+		result.basisValues[i] = functions[i]->evaluate(param_u, param_v, param_u!=end_[0], param_v!=end_[1]);
 }
 #endif
 
@@ -502,6 +577,8 @@ void LRSplineSurface::computeBasis(double param_u, double param_v, Go::BasisPtsS
  *          If iEl is not used, then result will contain all Basisfunction in the entire LRSplineSurface object, with easier
  *          access through indexing, but will contain a lot of zeros. The derivatives are sorted in the following 1, du, dv,
  *          d2u, dudv, d2v, d3u, d2udv, dud2v, d3v, ...
+ *          If iEl is used and cacheBezierExtraction() has been called, the functions are evaluated through the Bezier
+ *          extraction operator of the element. The point is then assumed to lie on the (closed) element iEl.
  ***************************************************************************************************************************/
 void LRSplineSurface::computeBasis (double param_u,
                                     double param_v,
@@ -513,40 +590,82 @@ void LRSplineSurface::computeBasis (double param_u,
 	PROFILE("computeBasis()");
 #endif
 	result.clear();
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
+	if(nPts == 0)
+		return;
 	
-	result.resize(nPts);
-	int i=0;
-	for(it=itStart; it!=itStop; ++it, ++i)
-	    (*it)->evaluate(result[i], param_u, param_v, derivs, param_u!=end_[0], param_v!=end_[1]);
+	int nDerivs = (derivs+1)*(derivs+2)/2;
+	std::vector<double> values(nPts*nDerivs, 0.0);
+	if(iEl >= 0 && hasBezierExtraction()) {
+		// all functions are polynomials on the element: multiply the Bernstein basis by the element extraction operator
+		const std::vector<double> &C = bezierExtraction_[iEl];
+		const Element *el = element_[iEl];
+		int p0 = order_[0];
+		int p1 = order_[1];
+		std::vector<double> bu(p0*(derivs+1)), bv(p1*(derivs+1));
+		getBernsteinBasis(&bu[0], p0, el->umin(), el->umax(), param_u, derivs);
+		getBernsteinBasis(&bv[0], p1, el->vmin(), el->vmax(), param_v, derivs);
+		int k = 0;
+		for(int totDeriv=0; totDeriv<=derivs; totDeriv++) {
+			for(int d0=totDeriv; d0>-1; d0--, k++) {
+				const double *Bu = &bu[d0*p0];
+				const double *Bv = &bv[(totDeriv-d0)*p1];
+				int col = 0;
+				for(int v=0; v<p1; v++) {
+					for(int u=0; u<p0; u++, col++) {
+						double bernstein     = Bu[u]*Bv[v];
+						const double *column = &C[col*nPts];
+						for(int i=0; i<nPts; i++)
+							values[i*nDerivs+k] += column[i]*bernstein;
+					}
+				}
+			}
+		}
+	} else {
+		double parPt[]     = {param_u, param_v};
+		bool   fromRight[] = {param_u!=end_[0], param_v!=end_[1]};
+		Basisfunction::evaluate(values.data(), functions.data(), nPts, parPt, derivs, fromRight);
+	}
 
+	result.resize(nPts);
+	for(int i=0; i<nPts; i++)
+		result[i].assign(values.begin() + i*nDerivs, values.begin() + (i+1)*nDerivs);
 }
 
 /************************************************************************************************************************//**
  * \brief Get the element index of the element containing the parametric point (u,v)
  * \param u The u-coordinate 
  * \param v The v-coordinate
+ * \param hint Element index to test first, typically the result of the previous call. Owned by the caller, which makes it
+ *             safe to use from several threads evaluating the same LRSplineSurface
  * \return The index of the element which contains (u,v)
- * \details This is done by a linear search and with the number of elements equal to n, the complexity is O(n)
+ * \details The search is done in an ElementTree, and with the number of elements equal to n, the complexity is O(log n).
+ *          This function does not modify the LRSplineSurface and may be called concurrently
  ***************************************************************************************************************************/
-int LRSplineSurface::getElementContaining(double u, double v) const {
-	for(uint i=lastElementEvaluation; i<element_.size(); ++i)
-		if(element_[i]->umin() <= u && element_[i]->vmin() <= v) 
-			if((u < element_[i]->umax() || (u == end_[0] && u <= element_[i]->umax())) && 
-			   (v < element_[i]->vmax() || (v == end_[1] && v <= element_[i]->vmax()))) {
-				lastElementEvaluation = i;
-				return i;
-			}
-	for(uint i=0; i<lastElementEvaluation; ++i)
+int LRSplineSurface::getElementContaining(double u, double v, int hint) const {
+	if(hint >= 0 && (uint) hint < element_.size()) {
+		Element *el = element_[hint];
+		if(el->umin() <= u && el->vmin() <= v) 
+			if((u < el->umax() || (u == end_[0] && u <= el->umax())) && 
+			   (v < el->vmax() || (v == end_[1] && v <= el->vmax())))
+				return hint;
+	}
+
+	if(elementTree_.isBuilt()) {
+		double par[] = {u, v};
+		return elementTree_.getElementContaining(element_, par);
+	}
+
+	// no search tree available (i.e. empty or manually assembled object), fall back to a linear search
+	for(uint i=0; i<element_.size(); ++i)
 		if(element_[i]->umin() <= u && element_[i]->vmin() <= v) 
 			if((u < element_[i]->umax() || (u == end_[0] && u <= element_[i]->umax())) && 
-			   (v < element_[i]->vmax() || (v == end_[1] && v <= element_[i]->vmax()))) {
-				lastElementEvaluation = i;
+			   (v < element_[i]->vmax() || (v == end_[1] && v <= element_[i]->vmax())))
 				return i;
-			}
 	return -1;
 }
 
@@ -727,15 +846,8 @@ void LRSplineSurface::refineBasisFunction(const std::vector<int> &indices) {
 	std::vector<Meshline*> newLines;
 
 	/* first retrieve all meshlines needed */
-	int ib = 0;
-	HashSet_iterator<Basisfunction*> it = basis_.begin();
-	for(uint i=0; i<sortedInd.size(); i++) {
-		while(ib < sortedInd[i]) {
-			++ib;
-			++it;
-		}
-		getStructMeshLines(*it,newLines);
-	}
+	for(uint i=0; i<sortedInd.size(); i++)
+		getStructMeshLines(getBasisfunction(sortedInd[i]),newLines);
 
 	/* Do the actual refinement */
 	for(uint i=0; i<newLines.size(); i++) {
@@ -797,6 +909,7 @@ void LRSplineSurface::refineByDimensionIncrease(const std::vector<double> &errPe
 	Element       *e;
 	/* accumulate the error & index - vector */
 	std::vector<IndexDouble> errors;
+	std::vector<Basisfunction*> functions; // the functions to refine by index, since basis_ changes during refinement
 	if(refStrat_ == LR_STRUCTURED_MESH) { // error per-function
 		int i=0;
 		for(Basisfunction *b : basis_) {
@@ -805,6 +918,7 @@ void LRSplineSurface::refineByDimensionIncrease(const std::vector<double> &errPe
 				e = *(b->supportedElementBegin() + j);
 				errors[i].first += errPerElement[e->getId()];
 			}
+			functions.push_back(b);
 			i++;
 		}
 	} else {
@@ -815,29 +929,62 @@ void LRSplineSurface::refineByDimensionIncrease(const std::vector<double> &errPe
 	/* sort errors */
 	std::sort(errors.begin(), errors.end(), std::greater<IndexDouble>());
 
-	/* first retrieve all possible meshlines needed */
-	std::vector<std::vector<Meshline*> > newLines(errors.size(), std::vector<Meshline*>(0));
-	for(uint i=0; i<errors.size(); i++) {
-		if(refStrat_ == LR_MINSPAN)
-			getMinspanLines(errors[i].second, newLines[i]);
-		else if(refStrat_ == LR_FULLSPAN) 
-			getFullspanLines(errors[i].second, newLines[i]);
-		else if(refStrat_ == LR_STRUCTURED_MESH) {
-			Basisfunction *b = getBasisfunction(errors[i].second);
-			getStructMeshLines(b, newLines[i]);
-		}
-		// note that this is an excessive loop as it computes the meshlines for ALL elements,
-		// but we're only going to use a small part of this.
-	}
+	/* The meshlines are generated in error order, and only as far as needed. They must however be computed from the mesh as
+	 * it was before any of them were inserted. So before inserting the lines of one entry, the lines are generated for all
+	 * entries which this might change, see addAffectedEntries() */
+	std::vector<int> rank(errors.size()); // element (or function) index to position in errors
+	for(uint i=0; i<errors.size(); i++)
+		rank[errors[i].second] = i;
+	std::vector<std::pair<Basisfunction*,int> > functionIndex; // function pointer to index, sorted for lookup
+	for(uint i=0; i<functions.size(); i++)
+		functionIndex.push_back(std::make_pair(functions[i], (int) i));
+	std::sort(functionIndex.begin(), functionIndex.end());
+	std::vector<bool> generated(errors.size(), false);
+	uint              nGenerated = 0;
+	size_t            work       = 0; // number of functions and elements visited while looking up affected entries
+	std::map<int, std::vector<Meshline*> > newLines; // lines generated but not yet inserted, by position in errors
 
 	/* Do the actual refinement */
 	int target_n_functions = ceil(basis_.size()*(1+beta));
-	int i=0;
-	while( basis_.size() < target_n_functions ) {
+	std::vector<int> pending;
+	uint i=0;
+	while( basis_.size() < target_n_functions && i < errors.size() ) {
+		// generate the lines of entry i first, and then those of all entries that inserting them might change
+		pending.assign(1, i);
+		for(uint k=0; k<pending.size(); k++) {
+			int r = pending[k];
+			if(!generated[r]) {
+				generated[r] = true;
+				nGenerated++;
+				if(refStrat_ == LR_MINSPAN)
+					getMinspanLines(errors[r].second, newLines[r]);
+				else if(refStrat_ == LR_FULLSPAN) 
+					getFullspanLines(errors[r].second, newLines[r]);
+				else if(refStrat_ == LR_STRUCTURED_MESH)
+					getStructMeshLines(functions[errors[r].second], newLines[r]);
+			}
+			if(k > 0 || nGenerated == errors.size() || newLines[i].empty())
+				continue;
+
+			// the box around all lines of entry i
+			double lo[2] = { DBL_MAX,  DBL_MAX};
+			double hi[2] = {-DBL_MAX, -DBL_MAX};
+			for(Meshline *m : newLines[i]) {
+				int c = (m->span_u_line_) ? 1 : 0; // the constant parametric direction
+				lo[c]   = std::min(lo[c],   m->const_par_);
+				hi[c]   = std::max(hi[c],   m->const_par_);
+				lo[1-c] = std::min(lo[1-c], m->start_ - DOUBLE_TOL);
+				hi[1-c] = std::max(hi[1-c], m->stop_  + DOUBLE_TOL);
+			}
+			addAffectedEntries(lo, hi, rank, functionIndex, generated, work, pending);
+		}
+
 		for(uint j=0; j<newLines[i].size(); j++) {
 			Meshline *m = newLines[i][j];
 			insert_line(!m->is_spanning_u(), m->const_par_, m->start_, m->stop_, refKnotlineMult_);
+			delete m;
 		}
+		newLines.erase(i);
 		i++;
 	}
 
@@ -845,27 +992,128 @@ void LRSplineSurface::refineByDimensionIncrease(const std::vector<double> &errPe
 	aPosterioriFixes();
 
 	/* exit cleanly by deleting all temporary new lines */
-	for(uint i=0; i<newLines.size(); i++) 
-		for(uint j=0; j<newLines[i].size(); j++) 
-			delete newLines[i][j];
+	for(std::map<int, std::vector<Meshline*> >::iterator it=newLines.begin(); it!=newLines.end(); ++it)
+		for(uint j=0; j<it->second.size(); j++) 
+			delete it->second[j];
 }
 
+/************************************************************************************************************************//**
+ * \brief Inserts meshlines until the mesh has no gaps, no elements with too many T-joints and no elements with too large
+ *        aspect ratio (as far as each of these conditions is requested)
+ * \details Only the elements touching a line inserted since the last call are checked (see dirtyElements_). The lines
+ *          inserted by the fixes mark the elements along them as dirty in turn, and these are checked in the next round until
+ *          no more lines are inserted. The cost thus scales with the size of the refined region rather than the entire mesh
+ ***************************************************************************************************************************/
 void LRSplineSurface::aPosterioriFixes()  {
 	std::vector<Meshline*> *newLines = NULL;
-	int nFunc;
-	do {
-		nFunc = basis_.size();
+	std::set<int> dirty;
+	if(allElementsDirty_) {
+		for(uint i=0; i<element_.size(); i++)
+			dirty.insert(dirty.end(), i);
+		allElementsDirty_ = false;
+	} else {
+		dirty.swap(dirtyElements_);
+	}
+	dirtyElements_.clear();
+	while(!dirty.empty()) {
+		// elements along the lines inserted by one fix are checked by the following fixes in the same round as well
 		if(doCloseGaps_)
-			this->closeGaps(newLines);
+			this->closeGaps(dirty, newLines);
+		dirty.insert(dirtyElements_.begin(), dirtyElements_.end());
 		if(maxTjoints_ > 0)
-			this->enforceMaxTjoints(newLines);
+			this->enforceMaxTjoints(dirty, newLines);
+		dirty.insert(dirtyElements_.begin(), dirtyElements_.end());
 		if(doAspectRatioFix_)
-			this->enforceMaxAspectRatio(newLines);
-	} while(nFunc != basis_.size());
+			this->enforceMaxAspectRatio(dirty, newLines);
+		dirty.clear();
+		dirty.swap(dirtyElements_);
+	}
+}
+
+
+//! \brief Sorts meshlines by their position in meshline_
+static bool meshlineOrderLess(const Meshline *a, const Meshline *b) {
+	return a->order_ < b->order_;
+}
+
+/************************************************************************************************************************//**
+ * \brief Get the T-joints on all four sides of an element, i.e. the meshlines which end on the edges of the element
+ * \param el The element
+ * \param left   [out] Parameter values of the lines ending at the left edge (umin), coming from the left
+ * \param right  [out] Parameter values of the lines starting at the right edge (umax), going to the right
+ * \param top    [out] Parameter values of the lines starting at the top edge (vmax)
+ * \param bottom [out] Parameter values of the lines ending at the bottom edge (vmin)
+ * \details The values are listed in the order the lines appear in meshline_. Only the lines at parameter values inside the
+ *          element are looked up from the meshline index, rather than searching through all lines
+ ***************************************************************************************************************************/
+void LRSplineSurface::getTjoints(const Element *el, std::vector<double> &left, std::vector<double> &right, std::vector<double> &top, std::vector<double> &bottom) const {
+	left.clear();
+	right.clear();
+	top.clear();
+	bottom.clear();
+	std::vector<Meshline*> lines;
+	for(int span_u=0; span_u<2; span_u++) {
+		int c = span_u;   // the constant parametric direction of these lines
+		int v = 1-span_u; // the parametric direction along these lines
+		const std::map<double, std::vector<Meshline*> > &index = meshlineIndex_[span_u];
+		std::map<double, std::vector<Meshline*> >::const_iterator bucket = index.upper_bound(el->getParmin(c));
+		std::map<double, std::vector<Meshline*> >::const_iterator last   = index.lower_bound(el->getParmax(c));
+		for(; bucket != last; ++bucket)
+			for(Meshline *m : bucket->second)
+				if(m->start_ == el->getParmax(v) || m->stop_ == el->getParmin(v))
+					lines.push_back(m);
+	}
+	std::sort(lines.begin(), lines.end(), meshlineOrderLess);
+
+	for(Meshline *m : lines) {
+		if(m->span_u_line_) {
+			if(m->start_ == el->umax())
+				right.push_back(m->const_par_);
+			else
+				left.push_back(m->const_par_);
+		} else {
+			if(m->start_ == el->vmax())
+				top.push_back(m->const_par_);
+			else
+				bottom.push_back(m->const_par_);
+		}
+	}
 }
 
+/************************************************************************************************************************//**
+ * \brief Get the indices of all elements touching a meshline, including those split by it and those at its end points
+ * \param m The meshline
+ * \param elements [out] The element indices, in increasing order
+ ***************************************************************************************************************************/
+void LRSplineSurface::getElementsTouching(const Meshline *m, std::vector<int> &elements) const {
+	elements.clear();
+	if(!elementTree_.isBuilt()) {
+		for(uint i=0; i<element_.size(); i++)
+			elements.push_back(i);
+		return;
+	}
+	double lo[2], hi[2];
+	int c = (m->span_u_line_) ? 1 : 0; // the constant parametric direction
+	lo[c]   = m->const_par_;
+	hi[c]   = m->const_par_;
+	lo[1-c] = m->start_ - DOUBLE_TOL;
+	hi[1-c] = m->stop_  + DOUBLE_TOL;
+	elementTree_.getElementsOverlapping(element_, lo, hi, elements);
+}
 
 void LRSplineSurface::closeGaps(std::vector<Meshline*>* newLines) {
+	std::set<int> elements;
+	for(uint i=0; i<element_.size(); i++)
+		elements.insert(elements.end(), i);
+	closeGaps(elements, newLines);
+}
+
+/************************************************************************************************************************//**
+ * \brief Closes the gaps between lines ending on opposite sides of the same element, by extending them through it
+ * \param elements The indices of the elements to check
+ * \param newLines [out] If given, copies of all inserted meshlines are appended to this list
+ ***************************************************************************************************************************/
+void LRSplineSurface::closeGaps(const std::set<int> &elements, std::vector<Meshline*>* newLines) {
 	std::vector<double>  start_v;
 	std::vector<double>  stop_v ;
 	std::vector<double>  const_u  ;
@@ -873,30 +1121,13 @@ void LRSplineSurface::closeGaps(std::vector<Meshline*>* newLines) {
 	std::vector<double>  start_u;
 	std::vector<double>  stop_u ;
 	std::vector<double>  const_v  ;
-	for(uint i=0; i<element_.size(); i++) {
+	std::vector<double> left, right, top, bottom;
+	for(int i : elements) {
 		double umin = element_[i]->umin();
 		double umax = element_[i]->umax();
 		double vmin = element_[i]->vmin();
 		double vmax = element_[i]->vmax();
-		std::vector<double> left, right, top, bottom;
-		for(uint j=0; j<meshline_.size(); j++) {
-			Meshline *m = meshline_[j];
-			if(      m->span_u_line_ &&
-			         m->const_par_ > vmin &&
-			         m->const_par_ < vmax) {
-				if(m->start_ == umax)
-					right.push_back(m->const_par_);
-				else if(m->stop_ == umin)
-					left.push_back(m->const_par_);
-			} else if(!m->span_u_line_ &&
-			          m->const_par_ > umin &&
-			          m->const_par_ < umax) {
-				if(m->start_ == vmax)
-					top.push_back(m->const_par_);
-				else if(m->stop_ == vmin)
-					bottom.push_back(m->const_par_);
-			}
-		}
+		getTjoints(element_[i], left, right, top, bottom);
 		for(uint j=0; j<left.size(); j++)
 			for(uint k=0; k<right.size(); k++)
 				if(left[j] == right[k]) {
@@ -925,145 +1156,271 @@ void LRSplineSurface::closeGaps(std::vector<Meshline*>* newLines) {
 	}
 }
 
+/************************************************************************************************************************//**
+ * \brief Inserts meshlines until no element has more than maxTjoints_ T-joints on any of its sides
+ * \param newLines [out] If given, copies of all inserted meshlines are appended to this list
+ ***************************************************************************************************************************/
 void LRSplineSurface::enforceMaxTjoints(std::vector<Meshline*> *newLines) {
-	bool someFix = true;
-	while(someFix) {
-		someFix = false;
-		for(uint i=0; i<element_.size(); i++) {
-			double umin = element_[i]->umin();
-			double umax = element_[i]->umax();
-			double vmin = element_[i]->vmin();
-			double vmax = element_[i]->vmax();
-			std::vector<double> left, right, top, bottom;
-			for(uint j=0; j<meshline_.size(); j++) {
-				Meshline *m = meshline_[j];
-				if(      m->span_u_line_ &&
-						 m->const_par_ > vmin &&
-						 m->const_par_ < vmax) {
-					if(m->start_ == umax)
-						right.push_back(m->const_par_);
-					else if(m->stop_ == umin)
-						left.push_back(m->const_par_);
-				} else if(!m->span_u_line_ &&
-						  m->const_par_ > umin &&
-						  m->const_par_ < umax) {
-					if(m->start_ == vmax)
-						top.push_back(m->const_par_);
-					else if(m->stop_ == vmin)
-						bottom.push_back(m->const_par_);
+	std::set<int> elements;
+	for(uint i=0; i<element_.size(); i++)
+		elements.insert(elements.end(), i);
+	enforceMaxTjoints(elements, newLines);
+}
+
+/************************************************************************************************************************//**
+ * \brief Inserts meshlines until none of the given elements, nor any element affected by the inserted lines, has more than
+ *        maxTjoints_ T-joints on any of its sides
+ * \param elements The indices of the elements to check
+ * \param newLines [out] If given, copies of all inserted meshlines are appended to this list
+ * \details The elements are checked in passes of increasing element index, and each fix only affects the elements
+ *          touching the inserted lines. These are the only ones rechecked: later in the current pass if they come after
+ *          the fixed element, or in the next pass otherwise. This gives the same result as repeatedly sweeping through all
+ *          elements until nothing changes, without testing the entire mesh again after every fix
+ ***************************************************************************************************************************/
+void LRSplineSurface::enforceMaxTjoints(const std::set<int> &elements, std::vector<Meshline*> *newLines) {
+	std::set<int> thisPass(elements), nextPass;
+
+	std::vector<double> left, right, top, bottom;
+	std::vector<Meshline*> inserted;
+	std::vector<int> affected;
+	while(!thisPass.empty()) {
+		int i = *thisPass.begin();
+		thisPass.erase(thisPass.begin());
+		double umin = element_[i]->umin();
+		double umax = element_[i]->umax();
+		double vmin = element_[i]->vmin();
+		double vmax = element_[i]->vmax();
+		getTjoints(element_[i], left, right, top, bottom);
+
+		inserted.clear();
+		double best = DBL_MAX;
+		int bi      = -1;
+		if(left.size() > (uint) maxTjoints_) {
+			for(uint j=0; j<left.size(); j++) {
+				if(fabs(left[j] - (vmin+vmax)/2) < best) {
+					best = fabs(left[j] - (vmin+vmax)/2);
+					bi = j;
 				}
 			}
-			Meshline *m;
-			double best = DBL_MAX;
-			int bi      = -1;
-			if(left.size() > (uint) maxTjoints_) {
-				for(uint j=0; j<left.size(); j++) {
-					if(fabs(left[j] - (vmin+vmax)/2) < best) {
-						best = fabs(left[j] - (vmin+vmax)/2);
-						bi = j;
-					}
-				}
-				m = insert_const_v_edge(left[bi], umin, umax, refKnotlineMult_);
-				if(newLines != NULL)
-					newLines->push_back(m->copy());
-				if(refStrat_ == LR_STRUCTURED_MESH) {
-					m = insert_const_u_edge((umin+umax)/2, vmin, vmax, refKnotlineMult_);
-					if(newLines != NULL)
-						newLines->push_back(m->copy());
+			inserted.push_back(insert_const_v_edge(left[bi], umin, umax, refKnotlineMult_)->copy());
+			if(refStrat_ == LR_STRUCTURED_MESH)
+				inserted.push_back(insert_const_u_edge((umin+umax)/2, vmin, vmax, refKnotlineMult_)->copy());
+		} else if(right.size() > (uint) maxTjoints_) {
+			for(uint j=0; j<right.size(); j++) {
+				if(fabs(right[j] - (vmin+vmax)/2) < best) {
+					best = fabs(right[j] - (vmin+vmax)/2);
+					bi = j;
 				}
-				someFix = true;
-				continue;
 			}
-			if(right.size() > (uint) maxTjoints_) {
-				for(uint j=0; j<right.size(); j++) {
-					if(fabs(right[j] - (vmin+vmax)/2) < best) {
-						best = fabs(right[j] - (vmin+vmax)/2);
-						bi = j;
-					}
-				}
-				m = insert_const_v_edge(right[bi], umin, umax, refKnotlineMult_);
-				if(newLines != NULL)
-					newLines->push_back(m->copy());
-				if(refStrat_ == LR_STRUCTURED_MESH) {
-					m = insert_const_u_edge((umin+umax)/2, vmin, vmax, refKnotlineMult_);
-					if(newLines != NULL)
-						newLines->push_back(m->copy());
+			inserted.push_back(insert_const_v_edge(right[bi], umin, umax, refKnotlineMult_)->copy());
+			if(refStrat_ == LR_STRUCTURED_MESH)
+				inserted.push_back(insert_const_u_edge((umin+umax)/2, vmin, vmax, refKnotlineMult_)->copy());
+		} else if(top.size() > (uint) maxTjoints_) {
+			for(uint j=0; j<top.size(); j++) {
+				if(fabs(top[j] - (umin+umax)/2) < best) {
+					best = fabs(top[j] - (umin+umax)/2);
+					bi = j;
 				}
-				someFix = true;
-				continue;
 			}
-			if(top.size() > (uint) maxTjoints_) {
-				for(uint j=0; j<top.size(); j++) {
-					if(fabs(top[j] - (umin+umax)/2) < best) {
-						best = fabs(top[j] - (umin+umax)/2);
-						bi = j;
-					}
-				}
-				m = insert_const_u_edge(top[bi], vmin, vmax, refKnotlineMult_);
-				if(newLines != NULL)
-					newLines->push_back(m->copy());
-				if(refStrat_ == LR_STRUCTURED_MESH) {
-					m = insert_const_v_edge((vmin+vmax)/2, umin, umax, refKnotlineMult_);
-					if(newLines != NULL)
-						newLines->push_back(m->copy());
+			inserted.push_back(insert_const_u_edge(top[bi], vmin, vmax, refKnotlineMult_)->copy());
+			if(refStrat_ == LR_STRUCTURED_MESH)
+				inserted.push_back(insert_const_v_edge((vmin+vmax)/2, umin, umax, refKnotlineMult_)->copy());
+		} else if(bottom.size() > (uint) maxTjoints_) {
+			for(uint j=0; j<bottom.size(); j++) {
+				if(fabs(bottom[j] - (umin+umax)/2) < best) {
+					best = fabs(bottom[j] - (umin+umax)/2);
+					bi = j;
 				}
-				someFix = true;
-				continue;
 			}
-			if(bottom.size() > (uint) maxTjoints_) {
-				for(uint j=0; j<bottom.size(); j++) {
-					if(fabs(bottom[j] - (umin+umax)/2) < best) {
-						best = fabs(bottom[j] - (umin+umax)/2);
-						bi = j;
-					}
-				}
-				m = insert_const_u_edge(bottom[bi], vmin, vmax, refKnotlineMult_);
-				if(newLines != NULL)
-					newLines->push_back(m->copy());
-				if(refStrat_ == LR_STRUCTURED_MESH) {
-					m = insert_const_v_edge((vmin+vmax)/2, umin, umax, refKnotlineMult_);
-					if(newLines != NULL)
-						newLines->push_back(m->copy());
-				}
-				someFix = true;
-				continue;
+			inserted.push_back(insert_const_u_edge(bottom[bi], vmin, vmax, refKnotlineMult_)->copy());
+			if(refStrat_ == LR_STRUCTURED_MESH)
+				inserted.push_back(insert_const_v_edge((vmin+vmax)/2, umin, umax, refKnotlineMult_)->copy());
+		}
+
+		// only elements touching the new lines may have gotten new T-joints (or changed size). Copies of the lines are
+		// kept, since the second line of a structured mesh fix may be merged with the first one
+		for(Meshline *m : inserted) {
+			getElementsTouching(m, affected);
+			for(int j : affected) {
+				if(j > i)
+					thisPass.insert(j);
+				else
+					nextPass.insert(j);
 			}
+			if(newLines != NULL)
+				newLines->push_back(m);
+			else
+				delete m;
 		}
+		if(thisPass.empty())
+			thisPass.swap(nextPass);
 	}
 }
 
+/************************************************************************************************************************//**
+ * \brief Inserts meshlines until no element has an aspect ratio larger than maxAspectRatio_
+ * \param newLines [out] If given, copies of all inserted meshlines are appended to this list
+ ***************************************************************************************************************************/
 void LRSplineSurface::enforceMaxAspectRatio(std::vector<Meshline*>* newLines) {
-	bool somethingFixed = true;
-	while(somethingFixed) {
-		somethingFixed = false;
-		for(uint i=0; i<element_.size(); i++) {
-			double umin = element_[i]->umin();
-			double umax = element_[i]->umax();
-			double vmin = element_[i]->vmin();
-			double vmax = element_[i]->vmax();
-			bool insert_const_u =  umax-umin > maxAspectRatio_*(vmax-vmin);
-			bool insert_const_v =  vmax-vmin > maxAspectRatio_*(umax-umin);
-			if( insert_const_u || insert_const_v ) {
-				std::vector<Meshline*> splitLines; // should always contain exactly one meshline on function return
-				if(refStrat_ == LR_MINSPAN) 
-					getMinspanLines(i, splitLines);
-				else
-					getFullspanLines(i, splitLines);
+	std::set<int> elements;
+	for(uint i=0; i<element_.size(); i++)
+		elements.insert(elements.end(), i);
+	enforceMaxAspectRatio(elements, newLines);
+}
+
+/************************************************************************************************************************//**
+ * \brief Inserts meshlines until none of the given elements, nor any element split by the inserted lines, has an aspect
+ *        ratio larger than maxAspectRatio_
+ * \param elements The indices of the elements to check
+ * \param newLines [out] If given, copies of all inserted meshlines are appended to this list
+ * \details The first element (by index) which is too elongated is always the one fixed next. Since a fix only changes the
+ *          elements split by the inserted line, these are the only ones put back on the worklist, rather than starting
+ *          over from the first element after every fix. This gives the same sequence of fixes as the full rescans
+ ***************************************************************************************************************************/
+void LRSplineSurface::enforceMaxAspectRatio(const std::set<int> &elements, std::vector<Meshline*>* newLines) {
+	std::set<int> worklist(elements);
+
+	std::vector<int> affected;
+	size_t nRescans = 0;
+	while(!worklist.empty()) {
+		int i = *worklist.begin();
+		worklist.erase(worklist.begin());
+		double umin = element_[i]->umin();
+		double umax = element_[i]->umax();
+		double vmin = element_[i]->vmin();
+		double vmax = element_[i]->vmax();
+		bool insert_const_u =  umax-umin > maxAspectRatio_*(vmax-vmin);
+		bool insert_const_v =  vmax-vmin > maxAspectRatio_*(umax-umin);
+		if( insert_const_u || insert_const_v ) {
+			std::vector<Meshline*> splitLines; // should always contain exactly one meshline on function return
+			if(refStrat_ == LR_MINSPAN) 
+				getMinspanLines(i, splitLines);
+			else
+				getFullspanLines(i, splitLines);
+
+			
+			Meshline *m, *msplit;
+			msplit = splitLines.front();
+
+			m = insert_line(!msplit->is_spanning_u(), msplit->const_par_, msplit->start_, msplit->stop_, refKnotlineMult_);
+			if(newLines != NULL)
+				newLines->push_back(m->copy());
+
+			// recheck the elements along the (possibly merged) line, including i itself and the new halves
+			getElementsTouching(m, affected);
+			worklist.insert(affected.begin(), affected.end());
+			nRescans += affected.size();
+
+			delete msplit;
+		}
+	}
+#ifdef TIME_LRSPLINE
+	PROFILE_COUNT("aspect ratio rescans", nRescans);
+#endif
+}
 
-				
-				Meshline *m, *msplit;
-				msplit = splitLines.front();
+/************************************************************************************************************************//**
+ * \brief Sorts all meshlines by orientation and constant parameter for fast overlap queries in insert_line()
+ ***************************************************************************************************************************/
+void LRSplineSurface::buildMeshlineIndex() {
+	compactMeshlines();
+	meshlineIndex_[0].clear();
+	meshlineIndex_[1].clear();
+	for(uint i=0; i<meshline_.size(); i++) {
+		meshline_[i]->order_ = i;
+		addToMeshlineIndex(meshline_[i]);
+	}
+}
 
-				m = insert_line(!msplit->is_spanning_u(), msplit->const_par_, msplit->start_, msplit->stop_, refKnotlineMult_);
-				if(newLines != NULL)
-					newLines->push_back(m->copy());
+/************************************************************************************************************************//**
+ * \brief Closes the gaps left in meshline_ by lines which insert_line() has merged into others
+ * \details insert_line() removes a line in constant time by clearing its entry, so merging lines never has to search or
+ *          shift meshline_. The remaining lines are moved together here, keeping their order, before anything reads the
+ *          list. This costs O(n) once for any number of removals in between
+ ***************************************************************************************************************************/
+void LRSplineSurface::compactMeshlines() const {
+	if(nRemovedMeshlines_ == 0)
+		return;
+	uint j=0;
+	for(uint i=0; i<meshline_.size(); i++) {
+		if(meshline_[i] != NULL) {
+			meshline_[i]->order_ = j;
+			meshline_[j++] = meshline_[i];
+		}
+	}
+	meshline_.resize(j);
+	nRemovedMeshlines_ = 0;
+}
 
-				delete msplit;
-				somethingFixed = true;
+void LRSplineSurface::addToMeshlineIndex(Meshline *m) {
+	std::vector<Meshline*> &lines = meshlineIndex_[m->span_u_line_ ? 1 : 0][m->const_par_];
+	std::vector<Meshline*>::iterator it = lines.begin();
+	while(it != lines.end() && (*it)->start_ <= m->start_)
+		++it;
+	lines.insert(it, m);
+}
+
+void LRSplineSurface::removeFromMeshlineIndex(Meshline *m) {
+	std::map<double, std::vector<Meshline*> > &index = meshlineIndex_[m->span_u_line_ ? 1 : 0];
+	std::map<double, std::vector<Meshline*> >::iterator bucket = index.find(m->const_par_);
+	if(bucket == index.end())
+		return;
+	std::vector<Meshline*> &lines = bucket->second;
+	lines.erase(std::remove(lines.begin(), lines.end(), m), lines.end());
+	if(lines.empty())
+		index.erase(bucket);
+}
+
+/************************************************************************************************************************//**
+ * \brief Returns all meshlines with the same orientation and constant parameter that overlap the interval [start, stop]
+ * \param span_u    Orientation of the meshlines (see Meshline::is_spanning_u())
+ * \param const_par The constant parameter value of the meshlines
+ * \param start     Start of the interval
+ * \param stop      End of the interval
+ * \param lines     [out] The overlapping meshlines, sorted by their start parameter
+ * \details Runs in O(log n + k) time where n is the number of distinct parameter values and k the number of meshlines at
+ *          const_par. This replaces a linear search through all meshlines for every new line.
+ ***************************************************************************************************************************/
+void LRSplineSurface::getOverlappingMeshlines(bool span_u, double const_par, double start, double stop, std::vector<Meshline*> &lines) const {
+	const std::map<double, std::vector<Meshline*> > &index = meshlineIndex_[span_u ? 1 : 0];
+	std::map<double, std::vector<Meshline*> >::const_iterator bucket = index.lower_bound(const_par - DOUBLE_TOL);
+	for(; bucket != index.end() && bucket->first < const_par + DOUBLE_TOL; ++bucket) {
+		if(fabs(bucket->first - const_par) >= DOUBLE_TOL)
+			continue;
+		for(Meshline *m : bucket->second) {
+			if(m->start_ > stop) // lines are sorted by start_, none of the remaining ones overlap
 				break;
+			if(m->stop_ >= start)
+				lines.push_back(m);
+		}
+	}
+}
+
+/************************************************************************************************************************//**
+ * \brief Returns all meshlines which run through the interior of the support of a basis function from one side to the other
+ * \param b The basis function
+ * \param lines [out] The meshlines, in the order they appear in meshline_
+ * \details These are the only lines which may split b (see Meshline::splits()). Only the lines at parameter values inside
+ *          the support of b are looked up, rather than testing b against all meshlines
+ ***************************************************************************************************************************/
+void LRSplineSurface::getMeshlinesCrossing(const Basisfunction *b, std::vector<Meshline*> &lines) const {
+	lines.clear();
+	for(int span_u=0; span_u<2; span_u++) {
+		int c = span_u;   // the constant parametric direction of these lines
+		int v = 1-span_u; // the parametric direction along these lines
+		const std::map<double, std::vector<Meshline*> > &index = meshlineIndex_[span_u];
+		std::map<double, std::vector<Meshline*> >::const_iterator bucket = index.upper_bound(b->getParmin(c));
+		std::map<double, std::vector<Meshline*> >::const_iterator last   = index.lower_bound(b->getParmax(c));
+		for(; bucket != last; ++bucket) {
+			for(Meshline *m : bucket->second) {
+				if(m->start_ > b->getParmin(v) + DOUBLE_TOL) // lines are sorted by start_, none of the remaining ones span b
+					break;
+				if(m->stop_ >= b->getParmax(v) - DOUBLE_TOL)
+					lines.push_back(m);
 			}
 		}
 	}
+	std::sort(lines.begin(), lines.end(), meshlineOrderLess);
 }
 
 Meshline* LRSplineSurface::insert_const_u_edge(double u, double start_v, double stop_v, int multiplicity) {
@@ -1079,100 +1436,147 @@ Meshline* LRSplineSurface::insert_line(bool const_u, double const_par, double st
 #ifdef TIME_LRSPLINE
 	PROFILE("line verification");
 #endif
-	newline = new Meshline(!const_u, const_par, start, stop, multiplicity);
+	newline = new (meshlinePool_.allocate()) Meshline(!const_u, const_par, start, stop, multiplicity);
 	newline->type_ = NEWLINE;
-	for(uint i=0; i<meshline_.size(); i++) {
-		// if newline overlaps any existing ones (may be multiple existing ones)
-		// let newline be the entire length of all merged and delete the unused ones
-
-		if(meshline_[i]->is_spanning_u() != const_u && fabs(meshline_[i]->const_par_-const_par)<DOUBLE_TOL && 
-		   meshline_[i]->start_ <= stop && meshline_[i]->stop_ >= start)  { // meshline_[i] overlaps with newline
+	Meshline *existing = NULL;        // meshline_ entry which already contains newline
+	std::vector<Meshline*> overlapping; // existing lines that newline overlaps (may be multiple)
+	std::vector<Meshline*> removed;     // existing lines which are merged into newline
+	getOverlappingMeshlines(!const_u, const_par, start, stop, overlapping);
+	for(Meshline *m : overlapping) {
+		// newline overlaps m. Let newline be the entire length of all merged and delete the unused ones
+
+		if(m->start_ <= start && 
+		   m->stop_  >= stop ) { // newline completely contained in m
+		   
+			if(m->multiplicity_ < newline->multiplicity_) { // increasing multiplicity
+				if(m->start_ == start && 
+				   m->stop_  == stop ) { // increasing the mult of the entire line
 
-			if(meshline_[i]->start_ <= start && 
-			   meshline_[i]->stop_  >= stop ) { // newline completely contained in meshline_[i]
-			   
-				if(meshline_[i]->multiplicity_ < newline->multiplicity_) { // increasing multiplicity
-					if(meshline_[i]->start_ == start && 
-					   meshline_[i]->stop_  == stop ) { // increasing the mult of the entire line
-
-						// keeping newline, getting rid of the old line
-						delete meshline_[i];
-						meshline_.erase(meshline_.begin() + i);
-						i--;
+					// keeping newline, getting rid of the old line
+					removed.push_back(m);
 
-					} else { // increasing multiplicity of partial line 
-						// do nothing. Keep the entire length meshline_[i], and add newline
+				} else { // increasing multiplicity of partial line 
+					// do nothing. Keep the entire length m, and add newline
 
-					}
-
-				} else { // line exist already, do nothing
-					delete newline;
-					return meshline_[i];
 				}
-			} else { // newline overlaps meshline_[i]. Keep (and update) newline, delete meshline_[i]
 
-				// update refinement type (for later analysis of linear independence)
-				if(newline->type_ == ELONGATION)   // overlaps two existing lines => MERGING
-					newline->type_ = MERGING;
-				else if(newline->type_ != MERGING) // overlaps one existing line => ELONGATION
-					newline->type_ = ELONGATION;
+			} else { // line exist already, do nothing
+				existing = m;
+				break;
+			}
+		} else { // newline overlaps m. Keep (and update) newline, delete m
 
-				// update the length of the line with the lowest multiplicity
-				if(meshline_[i]->multiplicity_ < newline->multiplicity_) {
-					if(meshline_[i]->start_ > start) meshline_[i]->start_ = newline->start_;
-					if(meshline_[i]->stop_  < stop ) meshline_[i]->stop_  = newline->stop_;
+			// update refinement type (for later analysis of linear independence)
+			if(newline->type_ == ELONGATION)   // overlaps two existing lines => MERGING
+				newline->type_ = MERGING;
+			else if(newline->type_ != MERGING) // overlaps one existing line => ELONGATION
+				newline->type_ = ELONGATION;
 
-				} else if(meshline_[i]->multiplicity_ > newline->multiplicity_) {
-					if(meshline_[i]->start_ < start) newline->start_ = meshline_[i]->start_;
-					if(meshline_[i]->stop_  > stop ) newline->stop_  = meshline_[i]->stop_;
+			// update the length of the line with the lowest multiplicity
+			if(m->multiplicity_ < newline->multiplicity_) {
+				removeFromMeshlineIndex(m); // changing start_ may change its position in the index
+				if(m->start_ > start) m->start_ = newline->start_;
+				if(m->stop_  < stop ) m->stop_  = newline->stop_;
+				addToMeshlineIndex(m);
 
-				} else { // for equal mult, we only keep newline and remove the previous line
-					if(meshline_[i]->start_ < start) newline->start_ = meshline_[i]->start_;
-					if(meshline_[i]->stop_  > stop ) newline->stop_  = meshline_[i]->stop_;
+			} else if(m->multiplicity_ > newline->multiplicity_) {
+				if(m->start_ < start) newline->start_ = m->start_;
+				if(m->stop_  > stop ) newline->stop_  = m->stop_;
 
-					// keeping newline, getting rid of the old line
-					delete meshline_[i];
-					meshline_.erase(meshline_.begin() + i);
-					i--;
-				} 
+			} else { // for equal mult, we only keep newline and remove the previous line
+				if(m->start_ < start) newline->start_ = m->start_;
+				if(m->stop_  > stop ) newline->stop_  = m->stop_;
+
+				// keeping newline, getting rid of the old line
+				removed.push_back(m);
+			} 
 
-			}
 		}
 	}
+	for(Meshline *m : removed) { // clear its entry in meshline_, the gap is closed by compactMeshlines()
+		meshline_[m->order_] = NULL;
+		nRemovedMeshlines_++;
+		removeFromMeshlineIndex(m);
+		meshlinePool_.destroy(m);
+	}
+#ifdef TIME_LRSPLINE
+	PROFILE_COUNT("LV-meshline visits", overlapping.size() + removed.size());
+#endif
+	if(existing != NULL) {
+		meshlinePool_.destroy(newline);
+		return existing;
+	}
 	}
 
 	HashSet<Basisfunction*> newFuncStp1, newFuncStp2;
 	HashSet<Basisfunction*> removeFunc;
+	std::set<const Element*> touched; // elements with changed support, only tracked while there are quadrature values cached
+	bezierExtraction_.clear(); // element supports change below
 
 	{ // STEP 1: test EVERY function against the NEW meshline
 #ifdef TIME_LRSPLINE
 	PROFILE("STEP 1");
 #endif
+	// only functions and elements touching the line can be split by it, so search for these in the box around it
+	double lo[2], hi[2];
+	int c = (const_u) ? 0 : 1; // the constant parametric direction
+	lo[c]   = newline->const_par_;
+	hi[c]   = newline->const_par_;
+	lo[1-c] = newline->start_ - DOUBLE_TOL;
+	hi[1-c] = newline->stop_  + DOUBLE_TOL;
 	{
 #ifdef TIME_LRSPLINE
 	PROFILE("S1-basissplit");
 #endif
-	for(Basisfunction* b : basis_) {
-		if(newline->splits(b)) {
-			int nKnots = newline->nKnotsIn(b);
-			if( nKnots < newline->multiplicity_ ) {
-				removeFunc.insert(b);
-				split( const_u, b, const_par, newline->multiplicity_-nKnots, newFuncStp1 );
-			}
+	std::vector<Basisfunction*> candidates, splitFunctions;
+	if(!getBasisfunctionsOverlapping(lo, hi, candidates))
+		candidates.assign(basis_.begin(), basis_.end());
+	for(Basisfunction* b : candidates)
+		if(newline->splits(b))
+			splitFunctions.push_back(b);
+	sortInBasisOrder(splitFunctions); // process them in the same order as a search through all of basis_ would
+	for(Basisfunction* b : splitFunctions) {
+		int nKnots = newline->nKnotsIn(b);
+		if( nKnots < newline->multiplicity_ ) {
+			removeFunc.insert(b);
+			split( const_u, b, const_par, newline->multiplicity_-nKnots, newFuncStp1 );
 		}
 	}
 	for(Basisfunction* b : removeFunc) {
+		if(!quadrature_.empty())
+			touched.insert(b->supportedElementBegin(), b->supportedElementEnd());
 		basis_.erase(b);
-		delete b;
+		basisPool_.destroy(b);
 	}
 	} // end profiler
 	{
 #ifdef TIME_LRSPLINE
 	PROFILE("S1-elementsplit");
 #endif
-	for(uint i=0; i<element_.size(); i++) {
-		if(newline->splits(element_[i]))
-			element_.push_back(element_[i]->split(newline->is_spanning_u(), newline->const_par_));
+	// the halves appended to element_ have the line on their boundary, so only elements existing up front are split
+	std::vector<int> nearby;
+	if(elementTree_.isBuilt()) {
+		elementTree_.getElementsOverlapping(element_, lo, hi, nearby);
+	} else {
+		for(uint i=0; i<element_.size(); i++)
+			nearby.push_back(i);
+	}
+	uint nOld = element_.size();
+	for(int i : nearby) {
+		if(newline->splits(element_[i])) {
+			elementTree_.removeElement(element_, i);
+			if(!quadrature_.empty())
+				touched.insert(element_[i]);
+			element_.push_back(element_[i]->split(newline->is_spanning_u(), newline->const_par_, &elementPool_));
+			elementTree_.addElement(element_, i);
+			elementTree_.addElement(element_, element_.size()-1);
+		}
+	}
+	// all elements along the line, including the new halves, need to be checked again by aPosterioriFixes()
+	if(!allElementsDirty_) {
+		dirtyElements_.insert(nearby.begin(), nearby.end());
+		for(uint i=nOld; i<element_.size(); i++)
+			dirtyElements_.insert(dirtyElements_.end(), i);
 	}
 	} // end profiler (elementsplit)
 	} // end profiler (step 1)
@@ -1181,17 +1585,25 @@ Meshline* LRSplineSurface::insert_line(bool const_u, double const_par, double st
 #ifdef TIME_LRSPLINE
 	PROFILE("STEP 2");
 #endif
+	newline->order_ = meshline_.size();
 	meshline_.push_back(newline);
+	addToMeshlineIndex(newline);
+	std::vector<Meshline*> crossing;
+	size_t nTests  = 0;
+	size_t nSplits = 0;
 	while(newFuncStp1.size() > 0) {
 		Basisfunction *b = newFuncStp1.pop();
 		bool splitMore = false;
-		for(Meshline *m : meshline_) {
+		getMeshlinesCrossing(b, crossing);
+		for(Meshline *m : crossing) {
+			nTests++;
 			if(m->splits(b)) {
 				int nKnots = m->nKnotsIn(b);
 				if( nKnots < m->multiplicity_ ) {
 					splitMore = true;
+					nSplits++;
 					split( !m->is_spanning_u(), b, m->const_par_, m->multiplicity_-nKnots, newFuncStp1);
-					delete b;
+					basisPool_.destroy(b);
 					break;
 				}
 			}
@@ -1199,8 +1611,14 @@ Meshline* LRSplineSurface::insert_line(bool const_u, double const_par, double st
 		if(!splitMore)
 			basis_.insert(b);
 	}
+#ifdef TIME_LRSPLINE
+	PROFILE_COUNT("S2-meshline tests", nTests);
+	PROFILE_COUNT("S2-splits",         nSplits);
+#endif
 	} // end profiler (step 2)
 
+	invalidateQuadratureCache(touched);
+
 	return newline;
 }
 
@@ -1215,7 +1633,7 @@ void LRSplineSurface::split(bool insert_in_u, Basisfunction* b, double new_knot,
 
 	// create the new functions b1 and b2
 	Basisfunction *b1, *b2;
-	std::vector<double> knot = (insert_in_u) ? (*b)[0]  : (*b)[1];
+	std::vector<double> knot((*b)[insert_in_u ? 0 : 1].begin(), (*b)[insert_in_u ? 0 : 1].end());
 	int     p                = (insert_in_u) ? order_[0] : order_[1];
 	int     insert_index = 0;
 	if(new_knot < knot[0] || knot[p] < new_knot)
@@ -1229,30 +1647,30 @@ void LRSplineSurface::split(bool insert_in_u, Basisfunction* b, double new_knot,
 	newKnot[0] = new_knot;
 	std::sort(newKnot.begin(), newKnot.begin() + p + 2);
 	if(insert_in_u) {
-		b1 = new Basisfunction(newKnot.begin()  , (*b)[1].begin(), b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha1);
-		b2 = new Basisfunction(newKnot.begin()+1, (*b)[1].begin(), b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha2);
+		b1 = new (basisPool_.allocate()) Basisfunction(newKnot.begin()  , (*b)[1].begin(), b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha1);
+		b2 = new (basisPool_.allocate()) Basisfunction(newKnot.begin()+1, (*b)[1].begin(), b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha2);
 	} else { // insert in v
-		b1 = new Basisfunction((*b)[0].begin(), newKnot.begin(),     b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha1);
-		b2 = new Basisfunction((*b)[0].begin(), newKnot.begin() + 1, b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha2);
+		b1 = new (basisPool_.allocate()) Basisfunction((*b)[0].begin(), newKnot.begin(),     b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha1);
+		b2 = new (basisPool_.allocate()) Basisfunction((*b)[0].begin(), newKnot.begin() + 1, b->cp(), b->dim(), order_[0], order_[1], b->w()*alpha2);
 	}
 
 	// add any brand new functions and detect their support elements
 	HashSet_iterator<Basisfunction*> it = basis_.find(b1);
 	if(it != basis_.end()) {
 		**it += *b1;
-		delete b1;
+		basisPool_.destroy(b1);
 	} else {
 		it = newFunctions.find(b1);
 		if(it != newFunctions.end()) {
 			**it += *b1;
-			delete b1;
+			basisPool_.destroy(b1);
 		} else {
 			updateSupport(b1, b->supportedElementBegin(), b->supportedElementEnd());
 			bool recursive_split = (multiplicity > 1) && ( ( insert_in_u && (*b1)[0][order_[0]]!=new_knot) ||
 			                                               (!insert_in_u && (*b1)[1][order_[1]]!=new_knot)  );
 			if(recursive_split) {
 				split( insert_in_u, b1, new_knot, multiplicity-1, newFunctions);
-				delete b1;
+				basisPool_.destroy(b1);
 			} else {
 				newFunctions.insert(b1);
 			}
@@ -1261,19 +1679,19 @@ void LRSplineSurface::split(bool insert_in_u, Basisfunction* b, double new_knot,
 	it = basis_.find(b2);
 	if(it != basis_.end()) {
 		**it += *b2;
-		delete b2;
+		basisPool_.destroy(b2);
 	} else {
 		it = newFunctions.find(b2);
 		if(it != newFunctions.end()) {
 			**it += *b2;
-			delete b2;
+			basisPool_.destroy(b2);
 		} else {
 			updateSupport(b2, b->supportedElementBegin(), b->supportedElementEnd());
 			bool recursive_split = (multiplicity > 1) && ( ( insert_in_u && (*b2)[0][0]!=new_knot) ||
 			                                               (!insert_in_u && (*b2)[1][0]!=new_knot)  );
 			if(recursive_split) {
 				split( insert_in_u, b2, new_knot, multiplicity-1, newFunctions);
-				delete b2;
+				basisPool_.destroy(b2);
 			} else {
 				newFunctions.insert(b2);
 			}
@@ -1283,6 +1701,7 @@ void LRSplineSurface::split(bool insert_in_u, Basisfunction* b, double new_knot,
 }
 
 void LRSplineSurface::getGlobalKnotVector(std::vector<double> &knot_u, std::vector<double> &knot_v) const {
+	compactMeshlines();
 	getGlobalUniqueKnotVector(knot_u, knot_v);
 
 	// add in duplicates where apropriate
@@ -1311,6 +1730,7 @@ void LRSplineSurface::getGlobalKnotVector(std::vector<double> &knot_u, std::vect
 }
 
 void LRSplineSurface::getGlobalUniqueKnotVector(std::vector<double> &knot_u, std::vector<double> &knot_v) const {
+	compactMeshlines();
 	knot_u.clear();
 	knot_v.clear();
 	// create a huge list of all line instances
@@ -1945,6 +2365,7 @@ bool LRSplineSurface::isLinearIndepByFloatingPointMappingMatrix(bool verbose) co
 }
 
 double LRSplineSurface::makeIntegerKnots() {
+	compactMeshlines();
 	// find the smallest knot interval
 	double smallKnotU = DBL_MAX;
 	double smallKnotV = DBL_MAX;
@@ -1966,6 +2387,7 @@ double LRSplineSurface::makeIntegerKnots() {
 		m->start_     = floor(m->start_    /scale + 0.5);
 		m->stop_      = floor(m->stop_     /scale + 0.5);
 	}
+	buildMeshlineIndex();
 
 	// scale all element values 
 	Element *e;
@@ -1977,12 +2399,17 @@ double LRSplineSurface::makeIntegerKnots() {
 		e->setVmax( floor(e->vmax() /scale + 0.5));
 	}
 
-	// scale all basis functions values
-	for(Basisfunction *b : basis_) {
+	// scale all basis functions values. This changes their hash codes, so they are reinserted in basis_, which is the only
+	// hashed container holding them (element supports are plain arrays)
+	std::vector<Basisfunction*> functions(basis_.begin(), basis_.end());
+	basis_.clear();
+	for(Basisfunction *b : functions) {
 		for(int j=0; j<order_[0]+1; j++)
 			(*b)[0][j] = floor((*b)[0][j]/scale + 0.5);
 		for(int j=0; j<order_[1]+1; j++)
 			(*b)[1][j] = floor((*b)[1][j]/scale + 0.5);
+		b->resetHashCode();
+		basis_.insert(b);
 	}
 	
 	// scale all LRSplineSurface values
@@ -1991,6 +2418,10 @@ double LRSplineSurface::makeIntegerKnots() {
 	end_[0]   = floor(end_[0]  /scale + 0.5);
 	end_[1]   = floor(end_[1]  /scale + 0.5);
 
+	bezierExtraction_.clear();
+	invalidateQuadratureCache();
+	elementTree_.build(element_, start_, end_);
+
 	return scale;
 }
 
@@ -2003,6 +2434,7 @@ double LRSplineSurface::makeIntegerKnots() {
  *          degree in u-direction is reduced by 1, while v-direction remains unchanged. 
  ***************************************************************************************************************************/
 std::vector<LRSplineSurface*> LRSplineSurface::getDerivativeSpace() const {
+	compactMeshlines();
 	int p1 = order_[0];
 	int p2 = order_[1];
 	std::vector<double> knotU(2*p1);
@@ -2047,6 +2479,7 @@ std::vector<LRSplineSurface*> LRSplineSurface::getDerivativeSpace() const {
  *          created first as this is of the highest degree and thus comprimise a stricter requirement on meshline length.
  ***************************************************************************************************************************/
 LRSplineSurface* LRSplineSurface::getPrimalSpace() const {
+	compactMeshlines();
 	int p1 = order_[0]-1;
 	int p2 = order_[1]-1;
 	std::vector<double> knotU(2*p1);
@@ -2086,6 +2519,7 @@ LRSplineSurface* LRSplineSurface::getPrimalSpace() const {
  *          place, but with higher multiplicity which gives them the same continuity as the initial basis.
  ***************************************************************************************************************************/
 LRSplineSurface* LRSplineSurface::getRaiseOrderSpace(int raiseOrderU, int raiseOrderV) const {
+	compactMeshlines();
 	int p1 = order_[0]+raiseOrderU;
 	int p2 = order_[1]+raiseOrderV;
 	std::vector<double> knotU(2*p1);
@@ -2122,6 +2556,7 @@ LRSplineSurface* LRSplineSurface::getRaiseOrderSpace(int raiseOrderU, int raiseO
  *          continuity. Note that any existing meshlines of lower continuity is unchanged by this call.
  ***************************************************************************************************************************/
 bool LRSplineSurface::setGlobalContinuity(int contU, int contV) {
+	compactMeshlines();
 	if(contU < -1 || contV < -1)
 		return false;
 	std::vector<Meshline*> existingLines;
@@ -2147,6 +2582,7 @@ bool LRSplineSurface::setGlobalContinuity(int contU, int contV) {
  * \returns True if operation was successful. False if error on input parameters
  ***************************************************************************************************************************/
 bool LRSplineSurface::decreaseContinuity(int du, int dv) {
+	compactMeshlines();
 	if(du < 0 || dv < 0) {
 		return false;
 	}
@@ -2206,15 +2642,19 @@ void LRSplineSurface::getDiagonalBasisfunctions(std::vector<int> &result) const
  *        during refinement. This function fixes them a priori.
  ***************************************************************************************************************************/
 void LRSplineSurface::aPosterioriFixElements() {
+	compactMeshlines();
 	for(uint i=0; i<element_.size(); i++) {
 		for(uint j=0; j<meshline_.size(); j++) {
 			if(meshline_[j]->splits(element_[i])) {
-				element_.push_back(element_[i]->split(meshline_[j]->is_spanning_u(), meshline_[j]->const_par_));
+				element_.push_back(element_[i]->split(meshline_[j]->is_spanning_u(), meshline_[j]->const_par_, &elementPool_));
 				i=0;
 				break;
 			}
 		}
 	}
+	bezierExtraction_.clear();
+	invalidateQuadratureCache();
+	elementTree_.build(element_, start_, end_);
 }
 
 void LRSplineSurface::getBezierElement(int iEl, std::vector<double> &controlPoints) const {
@@ -2419,6 +2859,8 @@ void LRSplineSurface::read(std::istream &is) {
 	meshline_.resize(nMeshlines);
 	element_.resize(nElements);
 	std::vector<Basisfunction*> basisVector(nBasis);
+	dirtyElements_.clear();
+	allElementsDirty_ = true;
 
 	// get rid of more comments and spaces
 	firstChar = is.peek();
@@ -2430,7 +2872,7 @@ void LRSplineSurface::read(std::istream &is) {
 
 	// read all basisfunctions
 	for(int i=0; i<nBasis; i++) {
-		Basisfunction *b = new Basisfunction(dim_, order_[0], order_[1]);
+		Basisfunction *b = new (basisPool_.allocate()) Basisfunction(dim_, order_[0], order_[1]);
 		b->read(is);
 		basis_.insert(b);
 		basisVector[i] = b;
@@ -2445,9 +2887,10 @@ void LRSplineSurface::read(std::istream &is) {
 	}
 
 	for(int i=0; i<nMeshlines; i++) {
-		meshline_[i] = new Meshline();
+		meshline_[i] = new (meshlinePool_.allocate()) Meshline();
 		meshline_[i]->read(is);
 	}
+	buildMeshlineIndex();
 
 	// get rid of more comments and spaces
 	firstChar = is.peek();
@@ -2459,7 +2902,7 @@ void LRSplineSurface::read(std::istream &is) {
 
 	// read elements and calculate patch boundaries
 	for(int i=0; i<nElements; i++) {
-		element_[i] = new Element();
+		element_[i] = new (elementPool_.allocate()) Element();
 		element_[i]->read(is);
 		element_[i]->updateBasisPointers(basisVector);
 		start_[0] = (element_[i]->umin() < start_[0]) ? element_[i]->umin() : start_[0];
@@ -2467,9 +2910,13 @@ void LRSplineSurface::read(std::istream &is) {
 		start_[1] = (element_[i]->vmin() < start_[1]) ? element_[i]->vmin() : start_[1];
 		end_[1]   = (element_[i]->vmax() > end_[1]  ) ? element_[i]->vmax() : end_[1]  ;
 	}
+	bezierExtraction_.clear();
+	invalidateQuadratureCache();
+	elementTree_.build(element_, start_, end_);
 }
 
 void LRSplineSurface::write(std::ostream &os) const {
+	compactMeshlines();
 	generateIDs();
 	os << std::setprecision(16);
 	os << "# LRSPLINE SURFACE\n";
@@ -2494,6 +2941,7 @@ void LRSplineSurface::write(std::ostream &os) const {
 }
 
 void LRSplineSurface::writePostscriptMesh(std::ostream &out, bool close, std::vector<int> *colorElements) const {
+	compactMeshlines();
 #ifdef TIME_LRSPLINE
 	PROFILE("Write EPS");
 #endif
@@ -2595,7 +3043,7 @@ void LRSplineSurface::writePostscriptElements(std::ostream &out, int nu, int nv,
 	y[0] = 1e7;
 	y[1] = -1e7;
 	for(Basisfunction *b : basis_) {
-		std::vector<double>::const_iterator cp = b->cp();
+		const double *cp = b->cp();
 		x[0] = (cp[0] < x[0]) ? cp[0] : x[0];
 		x[1] = (cp[0] > x[1]) ? cp[0] : x[1];
 		y[0] = (cp[1] < y[0]) ? cp[1] : y[0];
@@ -2751,7 +3199,7 @@ void LRSplineSurface::writePostscriptMeshWithControlPoints(std::ostream &out, in
 	y[0] = 1e7;
 	y[1] = -1e7;
 	for(Basisfunction *b : basis_) {
-		std::vector<double>::const_iterator cp = b->cp();
+		const double *cp = b->cp();
 		x[0] = (cp[0] < x[0]) ? cp[0] : x[0];
 		x[1] = (cp[0] > x[1]) ? cp[0] : x[1];
 		y[0] = (cp[1] < y[0]) ? cp[1] : y[0];
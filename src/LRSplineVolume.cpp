@@ -5,6 +5,7 @@
 #include "LRSpline/Profiler.h"
 
 #include <algorithm>
+#include <map>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
@@ -145,11 +146,11 @@ LRSplineVolume::LRSplineVolume(int n1, int n2, int n3, int order_u, int order_v,
 
 LRSplineVolume::~LRSplineVolume() {
 	for(Basisfunction* b : basis_)
-		delete b;
+		basisPool_.destroy(b);
 	for(uint i=0; i<meshrect_.size(); i++)
 		delete meshrect_[i];
 	for(uint i=0; i<element_.size(); i++)
-		delete element_[i];
+		elementPool_.destroy(element_[i]);
 }
 
 void LRSplineVolume::initMeta() {
@@ -197,6 +198,7 @@ LRSplineVolume* LRSplineVolume::copy() const {
 	returnvalue->end_[0]            = this->end_[0];
 	returnvalue->end_[1]            = this->end_[1];
 	returnvalue->end_[2]            = this->end_[2];
+	returnvalue->elementTree_.build(returnvalue->element_, returnvalue->start_, returnvalue->end_);
 	returnvalue->maxTjoints_       = this->maxTjoints_;
 	returnvalue->doCloseGaps_      = this->doCloseGaps_;
 	returnvalue->doAspectRatioFix_ = this->doAspectRatioFix_;
@@ -345,12 +347,18 @@ void LRSplineVolume::point(std::vector<std::vector<double> > &pts, double u, dou
 		iEl = getElementContaining(u,v,w);
 	if(iEl == -1)
 		return;
-	for(Basisfunction* b : element_[iEl]->support() ) {
-		b->evaluate(basis_ev, u,v,w, derivs, u_from_right, v_from_right, w_from_right);
-		for(uint i=0; i<pts.size(); i++)
+	std::vector<const Basisfunction*> functions(element_[iEl]->constSupportBegin(), element_[iEl]->constSupportEnd());
+	if(functions.empty())
+		return;
+	double parPt[]     = {u, v, w};
+	bool   fromRight[] = {u_from_right, v_from_right, w_from_right};
+	int    nDerivs     = pts.size();
+	basis_ev.resize(functions.size()*nDerivs);
+	Basisfunction::evaluate(basis_ev.data(), functions.data(), functions.size(), parPt, derivs, fromRight);
+	for(uint k=0; k<functions.size(); k++)
+		for(int i=0; i<nDerivs; i++)
 			for(int j=0; j<dim_; j++)
-				pts[i][j] += basis_ev[i]*b->cp(j);
-	}
+				pts[i][j] += basis_ev[k*nDerivs+i]*functions[k]->cp(j);
 }
 
 #ifdef HAS_GOTOOLS
@@ -358,17 +366,19 @@ void LRSplineVolume::computeBasis (double param_u, double param_v, double param_
 #ifdef TIME_LRSPLINE
 	PROFILE("computeBasis()");
 #endif
-	std::vector<double> values;
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	double values[10];
+	double parPt[]     = {param_u, param_v, param_w};
+	bool   fromRight[] = {param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]};
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
 	result.prepareDerivs(param_u, param_v, param_w, 0, 0, 0, nPts);
 
-	int i=0;
 	
-	for(it=itStart; it!=itStop; ++it, ++i) {
-		(*it)->evaluate(values, param_u, param_v, param_w, 2, param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]);
+	for(int i=0; i<nPts; i++) {
+		functions[i]->evaluate(values, parPt, 2, fromRight);
 	
 		result.basisValues[i]    = values[0];
 		result.basisDerivs_u[i]  = values[1];
@@ -387,16 +397,18 @@ void LRSplineVolume::computeBasis (double param_u, double param_v, double param_
 #ifdef TIME_LRSPLINE
 	PROFILE("computeBasis()");
 #endif
-	std::vector<double> values;
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	double values[4];
+	double parPt[]     = {param_u, param_v, param_w};
+	bool   fromRight[] = {param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]};
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
 	result.prepareDerivs(param_u, param_v, param_w, 0, 0, 0, nPts);
 	
-	int i=0;
-	for(it=itStart; it!=itStop; ++it, ++i) {
-		(*it)->evaluate(values, param_u, param_v, param_w, 1, param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]);
+	for(int i=0; i<nPts; i++) {
+		functions[i]->evaluate(values, parPt, 1, fromRight);
 		
 		result.basisValues[i]   = values[0];
 		result.basisDerivs_u[i] = values[1];
@@ -410,14 +422,14 @@ void LRSplineVolume::computeBasis(double param_u, double param_v, double param_w
 #ifdef TIME_LRSPLINE
 	PROFILE("computeBasis()");
 #endif
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
 	result.preparePts(param_u, param_v, param_w, 0, 0, 0, nPts);
-	int i=0;
-	for(it=itStart; it!=itStop; ++it, ++i)
-		result.basisValues[i] = (*it)->evaluate(param_u, param_v, param_w, param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]);
+	for(int i=0; i<nPts; i++)
+		result.basisValues[i] = functions[i]->evaluate(param_u, param_v, param_w, param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]);
 }
 #endif
 
@@ -432,37 +444,93 @@ void LRSplineVolume::computeBasis (double param_u,
 	PROFILE("computeBasis()");
 #endif
 	result.clear();
-	HashSet_const_iterator<Basisfunction*> it, itStop, itStart;
-	itStart = (iEl<0) ? basis_.begin() : element_[iEl]->constSupportBegin();
-	itStop  = (iEl<0) ? basis_.end()   : element_[iEl]->constSupportEnd();
-	int nPts= (iEl<0) ? basis_.size()  : element_[iEl]->nBasisFunctions();
-	result.resize(nPts);
+	std::vector<Basisfunction*> allFunctions;
+	if(iEl<0)
+		allFunctions.assign(basis_.begin(), basis_.end());
+	const std::vector<Basisfunction*> &functions = (iEl<0) ? allFunctions : element_[iEl]->support();
+	int nPts = functions.size();
+	if(nPts == 0)
+		return;
+
+	int nDerivs = (derivs+1)*(derivs+2)*(2*derivs+6)/12;
+	std::vector<double> values(nPts*nDerivs, 0.0);
+	if(iEl >= 0 && hasBezierExtraction()) {
+		// all functions are polynomials on the element: multiply the Bernstein basis by the element extraction operator
+		const std::vector<double> &C = bezierExtraction_[iEl];
+		const Element *el = element_[iEl];
+		int p0 = order_[0];
+		int p1 = order_[1];
+		int p2 = order_[2];
+		std::vector<double> bu(p0*(derivs+1)), bv(p1*(derivs+1)), bw(p2*(derivs+1));
+		getBernsteinBasis(&bu[0], p0, el->getParmin(0), el->getParmax(0), param_u, derivs);
+		getBernsteinBasis(&bv[0], p1, el->getParmin(1), el->getParmax(1), param_v, derivs);
+		getBernsteinBasis(&bw[0], p2, el->getParmin(2), el->getParmax(2), param_w, derivs);
+		int k = 0;
+		for(int totDeriv=0; totDeriv<=derivs; totDeriv++) {
+			for(int d0=totDeriv; d0>-1; d0--) {
+				for(int d1=totDeriv-d0; d1>-1; d1--, k++) {
+					const double *Bu = &bu[d0*p0];
+					const double *Bv = &bv[d1*p1];
+					const double *Bw = &bw[(totDeriv-d0-d1)*p2];
+					int col = 0;
+					for(int w=0; w<p2; w++) {
+						for(int v=0; v<p1; v++) {
+							for(int u=0; u<p0; u++, col++) {
+								double bernstein     = Bu[u]*Bv[v]*Bw[w];
+								const double *column = &C[col*nPts];
+								for(int i=0; i<nPts; i++)
+									values[i*nDerivs+k] += column[i]*bernstein;
+							}
+						}
+					}
+				}
+			}
+		}
+	} else {
+		double parPt[]     = {param_u, param_v, param_w};
+		bool   fromRight[] = {param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]};
+		Basisfunction::evaluate(values.data(), functions.data(), nPts, parPt, derivs, fromRight);
+	}
 
-	int i=0;
-	for(it=itStart; it!=itStop; ++it, ++i)
-	    (*it)->evaluate(result[i], param_u, param_v, param_w, derivs, param_u!=end_[0], param_v!=end_[1], param_w!=end_[2]);
+	result.resize(nPts);
+	for(int i=0; i<nPts; i++)
+		result[i].assign(values.begin() + i*nDerivs, values.begin() + (i+1)*nDerivs);
 }
 
-int LRSplineVolume::getElementContaining(double u, double v, double w) const {
-	for(uint i=lastElementEvaluation; i<element_.size(); ++i) {
-        Element* el = element_[i];
+/************************************************************************************************************************//**
+ * \brief Get the element index of the element containing the parametric point (u,v,w)
+ * \param u The u-coordinate 
+ * \param v The v-coordinate
+ * \param w The w-coordinate
+ * \param hint Element index to test first, typically the result of the previous call. Owned by the caller, which makes it
+ *             safe to use from several threads evaluating the same LRSplineVolume
+ * \return The index of the element which contains (u,v,w)
+ * \details The search is done in an ElementTree (octree), and with the number of elements equal to n, the complexity is
+ *          O(log n). This function does not modify the LRSplineVolume and may be called concurrently
+ ***************************************************************************************************************************/
+int LRSplineVolume::getElementContaining(double u, double v, double w, int hint) const {
+	if(hint >= 0 && (uint) hint < element_.size()) {
+		Element* el = element_[hint];
 		if(el->getParmin(0) <= u && el->getParmin(1) <= v && el->getParmin(2) <= w) 
 			if((u < el->getParmax(0) || (u == end_[0] && u <= el->getParmax(0))) && 
 			   (v < el->getParmax(1) || (v == end_[1] && v <= el->getParmax(1))) && 
-			   (w < el->getParmax(2) || (w == end_[2] && w <= el->getParmax(2)))) {
-				lastElementEvaluation = i;
-				return i;
-			}
+			   (w < el->getParmax(2) || (w == end_[2] && w <= el->getParmax(2))))
+				return hint;
 	}
-	for(int i=0; i<lastElementEvaluation; ++i) {
-        Element* el = element_[i];
+
+	if(elementTree_.isBuilt()) {
+		double par[] = {u, v, w};
+		return elementTree_.getElementContaining(element_, par);
+	}
+
+	// no search tree available (i.e. empty or manually assembled object), fall back to a linear search
+	for(uint i=0; i<element_.size(); ++i) {
+		Element* el = element_[i];
 		if(el->getParmin(0) <= u && el->getParmin(1) <= v && el->getParmin(2) <= w) 
 			if((u < el->getParmax(0) || (u == end_[0] && u <= el->getParmax(0))) && 
 			   (v < el->getParmax(1) || (v == end_[1] && v <= el->getParmax(1))) && 
-			   (w < el->getParmax(2) || (w == end_[2] && w <= el->getParmax(2)))) {
-				lastElementEvaluation = i;
+			   (w < el->getParmax(2) || (w == end_[2] && w <= el->getParmax(2))))
 				return i;
-			}
 	}
 	return -1;
 }
@@ -674,15 +742,8 @@ void LRSplineVolume::refineBasisFunction(const std::vector<int> &indices) {
 	std::vector<MeshRectangle*> newRects;
 
 	/* first retrieve all meshrects needed */
-	int ib = 0;
-	HashSet_iterator<Basisfunction*> it = basis_.begin();
-	for(uint i=0; i<sortedInd.size(); i++) {
-		while(ib < sortedInd[i]) {
-			++ib;
-			++it;
-		}
-		getStructMeshRects(*it,newRects);
-	}
+	for(uint i=0; i<sortedInd.size(); i++)
+		getStructMeshRects(getBasisfunction(sortedInd[i]),newRects);
 
 	/* Do the actual refinement */
 	for(MeshRectangle *m : newRects) 
@@ -723,6 +784,7 @@ void LRSplineVolume::refineByDimensionIncrease(const std::vector<double> &errPer
 
 	/* accumulate the error & index - vector */
 	std::vector<IndexDouble> errors;
+	std::vector<Basisfunction*> functions; // the functions to refine by index, since basis_ changes during refinement
 	if(refStrat_ == LR_STRUCTURED_MESH) { // error per-function
 		int i=0;
 		for(Basisfunction *b : basis_) {
@@ -731,8 +793,9 @@ void LRSplineVolume::refineByDimensionIncrease(const std::vector<double> &errPer
 				e = *(b->supportedElementBegin() + j);
 				errors[i].first += errPerElement[e->getId()];
 			}
+			functions.push_back(b);
+			i++;
 		}
-		i++;
 	} else {
 		for(uint i=0; i<element_.size(); i++) 
 			errors.push_back(IndexDouble(errPerElement[i], i));
@@ -741,33 +804,72 @@ void LRSplineVolume::refineByDimensionIncrease(const std::vector<double> &errPer
 	/* sort errors */
 	std::sort(errors.begin(), errors.end(), std::greater<IndexDouble>());
 
-	/* first retrieve all possible meshrects needed */
-	std::vector<std::vector<MeshRectangle*> > newRects(errors.size(), std::vector<MeshRectangle*>(0));
-	for(uint i=0; i<errors.size(); i++) {
-		if(refStrat_ == LR_MINSPAN)
-			getMinspanRects(errors[i].second, newRects[i]);
-		else if(refStrat_ == LR_FULLSPAN) 
-			getFullspanRects(errors[i].second, newRects[i]);
-		else if(refStrat_ == LR_STRUCTURED_MESH)  {
-			Basisfunction *b = getBasisfunction(errors[i].second);
-			getStructMeshRects(b, newRects[i]);
-		}
-		// note that this is an excessive loop as it computes the meshrects for ALL elements,
-		// but we're only going to use a small part of this.
-	}
+	/* The meshrects are generated in error order, and only as far as needed. They must however be computed from the mesh as
+	 * it was before any of them were inserted. So before inserting the rects of one entry, the rects are generated for all
+	 * entries which this might change, see addAffectedEntries() */
+	std::vector<int> rank(errors.size()); // element (or function) index to position in errors
+	for(uint i=0; i<errors.size(); i++)
+		rank[errors[i].second] = i;
+	std::vector<std::pair<Basisfunction*,int> > functionIndex; // function pointer to index, sorted for lookup
+	for(uint i=0; i<functions.size(); i++)
+		functionIndex.push_back(std::make_pair(functions[i], (int) i));
+	std::sort(functionIndex.begin(), functionIndex.end());
+	std::vector<bool> generated(errors.size(), false);
+	uint              nGenerated = 0;
+	size_t            work       = 0; // number of functions and elements visited while looking up affected entries
+	std::map<int, std::vector<MeshRectangle*> > newRects; // rects generated but not yet inserted, by position in errors
 
 	/* Do the actual refinement */
 	int target_n_functions = ceil(basis_.size()*(1+beta));
-	int i=0;
-	while( basis_.size() < target_n_functions ) {
-		for(uint j=0; j<newRects[i].size(); j++) {
-			insert_line(newRects[i][j]);
+	std::vector<int> pending;
+	uint i=0;
+	while( basis_.size() < target_n_functions && i < errors.size() ) {
+		// generate the rects of entry i first, and then those of all entries that inserting them might change
+		pending.assign(1, i);
+		for(uint k=0; k<pending.size(); k++) {
+			int r = pending[k];
+			if(!generated[r]) {
+				generated[r] = true;
+				nGenerated++;
+				if(refStrat_ == LR_MINSPAN)
+					getMinspanRects(errors[r].second, newRects[r]);
+				else if(refStrat_ == LR_FULLSPAN) 
+					getFullspanRects(errors[r].second, newRects[r]);
+				else if(refStrat_ == LR_STRUCTURED_MESH)
+					getStructMeshRects(functions[errors[r].second], newRects[r]);
+			}
+			if(k > 0 || nGenerated == errors.size() || newRects[i].empty())
+				continue;
+
+			// the box around all rects of entry i
+			double lo[3], hi[3];
+			for(int d=0; d<3; d++) {
+				lo[d] =  DBL_MAX;
+				hi[d] = -DBL_MAX;
+			}
+			for(MeshRectangle *m : newRects[i]) {
+				for(int d=0; d<3; d++) {
+					lo[d] = std::min(lo[d], m->start_[d] - DOUBLE_TOL);
+					hi[d] = std::max(hi[d], m->stop_[d]  + DOUBLE_TOL);
+				}
+			}
+			addAffectedEntries(lo, hi, rank, functionIndex, generated, work, pending);
 		}
+
+		// insert_line() takes over the rects
+		for(uint j=0; j<newRects[i].size(); j++)
+			insert_line(newRects[i][j]);
+		newRects.erase(i);
 		i++;
 	}
 
 	/* do a posteriori fixes to ensure a proper mesh */
 	// aPosterioriFixes();
+
+	/* exit cleanly by deleting all unused rects */
+	for(std::map<int, std::vector<MeshRectangle*> >::iterator it=newRects.begin(); it!=newRects.end(); ++it)
+		for(uint j=0; j<it->second.size(); j++) 
+			delete it->second[j];
 }
 
 #if 0
@@ -1057,12 +1159,38 @@ MeshRectangle* LRSplineVolume::insert_line(MeshRectangle *newRect) {
 
 	HashSet<Basisfunction*> newFuncStp1, newFuncStp2;
 	HashSet<Basisfunction*> removeFunc;
+	std::set<const Element*> touched; // elements with changed support, only tracked while there are quadrature values cached
+	bezierExtraction_.clear(); // element supports change below
 
 	{ // STEP 1: test EVERY function against the NEW meshrect
 #ifdef TIME_LRSPLINE
 	PROFILE("STEP 1");
 #endif
-	for(Basisfunction* b : basis_) {
+	// only functions with support on the new meshrectangles can be split, so fetch these from the elements around them
+	std::vector<Basisfunction*> candidates, splitFunctions;
+	double lo[3], hi[3];
+	for(int d=0; d<3; d++) {
+		lo[d] =  DBL_MAX;
+		hi[d] = -DBL_MAX;
+	}
+	for(MeshRectangle *m : newGuys) {
+		for(int d=0; d<3; d++) {
+			lo[d] = std::min(lo[d], m->start_[d] - DOUBLE_TOL);
+			hi[d] = std::max(hi[d], m->stop_[d]  + DOUBLE_TOL);
+		}
+	}
+	if(!getBasisfunctionsOverlapping(lo, hi, candidates))
+		candidates.assign(basis_.begin(), basis_.end());
+	for(Basisfunction* b : candidates) {
+		for(MeshRectangle *m : newGuys) {
+			if(m->splits(b)) {
+				splitFunctions.push_back(b);
+				break;
+			}
+		}
+	}
+	sortInBasisOrder(splitFunctions); // process them in the same order as a search through all of basis_ would
+	for(Basisfunction* b : splitFunctions) {
 		for(MeshRectangle *m : newGuys) {
 			if(m->splits(b)) {
 				int nKnots = m->nKnotsIn(b);
@@ -1075,13 +1203,32 @@ MeshRectangle* LRSplineVolume::insert_line(MeshRectangle *newRect) {
 		}
 	}
 	for(Basisfunction* b : removeFunc) {
+		if(!quadrature_.empty())
+			touched.insert(b->supportedElementBegin(), b->supportedElementEnd());
 		basis_.erase(b);
-		delete b;
+		basisPool_.destroy(b);
 	}
-	for(uint i=0; i<element_.size(); i++) {
+	// only elements around the new meshrectangles can be split. The halves appended to element_ are tested as well (as
+	// any of the other meshrectangles may split them), in the same order as a search through all of element_ would
+	std::vector<int> nearby;
+	if(elementTree_.isBuilt()) {
+		elementTree_.getElementsOverlapping(element_, lo, hi, nearby);
+	} else {
+		for(uint i=0; i<element_.size(); i++)
+			nearby.push_back(i);
+	}
+	uint nOld = element_.size();
+	for(uint k=0; k<nearby.size() + element_.size()-nOld; k++) {
+		uint i = (k < nearby.size()) ? nearby[k] : nOld + k-nearby.size();
 		for(MeshRectangle *m : newGuys) {
-			if(m->splits(element_[i]))
-				element_.push_back(element_[i]->split(m->constDirection(), m->constParameter()) );
+			if(m->splits(element_[i])) {
+				elementTree_.removeElement(element_, i);
+				if(!quadrature_.empty())
+					touched.insert(element_[i]);
+				element_.push_back(element_[i]->split(m->constDirection(), m->constParameter(), &elementPool_) );
+				elementTree_.addElement(element_, i);
+				elementTree_.addElement(element_, element_.size()-1);
+			}
 		}
 	}
 	} // end step 1 timer
@@ -1101,7 +1248,7 @@ MeshRectangle* LRSplineVolume::insert_line(MeshRectangle *newRect) {
 				if( nKnots < m->multiplicity_ ) {
 					splitMore = true;
 					split( m->constDirection(), b, m->constParameter(), m->multiplicity_-nKnots, newFuncStp1);
-					delete b;
+					basisPool_.destroy(b);
 					break;
 				}
 			}
@@ -1110,6 +1257,8 @@ MeshRectangle* LRSplineVolume::insert_line(MeshRectangle *newRect) {
 			basis_.insert(b);
 	}
 	} // end step 2 timer
+
+	invalidateQuadratureCache(touched);
 	return NULL;
 }
 
@@ -1120,7 +1269,7 @@ void LRSplineVolume::split(int constDir, Basisfunction *b, double new_knot, int
 
 	// create the new functions b1 and b2
 	Basisfunction *b1, *b2;
-	std::vector<double> knot = b->getknots(constDir);
+	std::vector<double> knot(b->getknots(constDir).begin(), b->getknots(constDir).end());
 	int     p                = b->getOrder(constDir);
 	int     insert_index     = 0;
 	if(new_knot < knot[0] || knot[p] < new_knot)
@@ -1134,32 +1283,32 @@ void LRSplineVolume::split(int constDir, Basisfunction *b, double new_knot, int
 	newKnot[0] = new_knot;
 	std::sort(newKnot.begin(), newKnot.begin() + p+2);
 	if(constDir == 0) {
-		b1 = new Basisfunction(newKnot.begin()  ,  (*b)[1].begin(),  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha1);
-		b2 = new Basisfunction(newKnot.begin()+1,  (*b)[1].begin(),  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha2);
+		b1 = new (basisPool_.allocate()) Basisfunction(newKnot.begin()  ,  (*b)[1].begin(),  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha1);
+		b2 = new (basisPool_.allocate()) Basisfunction(newKnot.begin()+1,  (*b)[1].begin(),  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha2);
 	} else if(constDir == 1) {
-		b1 = new Basisfunction((*b)[0].begin(), newKnot.begin()   ,  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha1);
-		b2 = new Basisfunction((*b)[0].begin(), newKnot.begin()+1 ,  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha2);
+		b1 = new (basisPool_.allocate()) Basisfunction((*b)[0].begin(), newKnot.begin()   ,  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha1);
+		b2 = new (basisPool_.allocate()) Basisfunction((*b)[0].begin(), newKnot.begin()+1 ,  (*b)[2].begin(), b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha2);
 	} else { // insert in w
-		b1 = new Basisfunction((*b)[0].begin(), (*b)[1].begin(),  newKnot.begin()   , b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha1);
-		b2 = new Basisfunction((*b)[0].begin(), (*b)[1].begin(),  newKnot.begin()+1 , b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha2);
+		b1 = new (basisPool_.allocate()) Basisfunction((*b)[0].begin(), (*b)[1].begin(),  newKnot.begin()   , b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha1);
+		b2 = new (basisPool_.allocate()) Basisfunction((*b)[0].begin(), (*b)[1].begin(),  newKnot.begin()+1 , b->cp(), b->dim(), order_[0], order_[1], order_[2], b->w()*alpha2);
 	}
 
 	// add any brand new functions and detect their support elements
 	HashSet_iterator<Basisfunction*> it = basis_.find(b1);
 	if(it != basis_.end()) {
 		**it += *b1;
-		delete b1;
+		basisPool_.destroy(b1);
 	} else {
 		it = newFunctions.find(b1);
 		if(it != newFunctions.end()) {
 			**it += *b1;
-			delete b1;
+			basisPool_.destroy(b1);
 		} else {
 			updateSupport(b1, b->supportedElementBegin(), b->supportedElementEnd());
 			bool recursive_split = (multiplicity > 1) && (*b1)[constDir].back() != new_knot;
 			if(recursive_split) {
 				split( constDir, b1, new_knot, multiplicity-1, newFunctions);
-				delete b1;
+				basisPool_.destroy(b1);
 			} else {
 				newFunctions.insert(b1);
 			}
@@ -1168,18 +1317,18 @@ void LRSplineVolume::split(int constDir, Basisfunction *b, double new_knot, int
 	it = basis_.find(b2);
 	if(it != basis_.end()) {
 		**it += *b2;
-		delete b2;
+		basisPool_.destroy(b2);
 	} else {
 		it = newFunctions.find(b2);
 		if(it != newFunctions.end()) {
 			**it += *b2;
-			delete b2;
+			basisPool_.destroy(b2);
 		} else {
 			updateSupport(b2, b->supportedElementBegin(), b->supportedElementEnd());
 			bool recursive_split = (multiplicity > 1) && (*b2)[constDir][0] != new_knot;
 			if(recursive_split) {
 				split( constDir, b2, new_knot, multiplicity-1, newFunctions);
-				delete b2;
+				basisPool_.destroy(b2);
 			} else {
 				newFunctions.insert(b2);
 			}
@@ -2126,7 +2275,7 @@ void LRSplineVolume::read(std::istream &is) {
 
 	// read all basisfunctions
 	for(int i=0; i<nBasis; i++) {
-		Basisfunction *b = new Basisfunction(dim_, 3, allOrder);
+		Basisfunction *b = new (basisPool_.allocate()) Basisfunction(dim_, 3, allOrder);
 		b->read(is);
 		basis_.insert(b);
 		basisVector[i] = b;
@@ -2155,7 +2304,7 @@ void LRSplineVolume::read(std::istream &is) {
 
 	// read elements and calculate patch boundaries
 	for(int i=0; i<nElements; i++) {
-		element_[i] = new Element();
+		element_[i] = new (elementPool_.allocate()) Element();
 		element_[i]->read(is);
 		element_[i]->updateBasisPointers(basisVector);
 		start_[0] = (element_[i]->getParmin(0) < start_[0]) ? element_[i]->getParmin(0) : start_[0];
@@ -2165,6 +2314,9 @@ void LRSplineVolume::read(std::istream &is) {
 		start_[2] = (element_[i]->getParmin(2) < start_[2]) ? element_[i]->getParmin(2) : start_[2];
 		end_[2]   = (element_[i]->getParmax(2) > end_[2]  ) ? element_[i]->getParmax(2) : end_[2]  ;
 	}
+	bezierExtraction_.clear();
+	invalidateQuadratureCache();
+	elementTree_.build(element_, start_, end_);
 }
 
 void LRSplineVolume::write(std::ostream &os) const {
@@ -16,6 +16,7 @@ Meshline::Meshline() {
 	stop_         = 0;
 	multiplicity_ = 0;
 	type_         = INITIAL;
+	order_        = 0;
 }
 
 Meshline::Meshline(bool span_u_line, double const_par, double start, double stop, int multiplicity) {
@@ -25,6 +26,7 @@ Meshline::Meshline(bool span_u_line, double const_par, double start, double stop
 	stop_         =  stop          ;
 	multiplicity_ =  multiplicity  ;
 	type_         =  INITIAL       ;
+	order_        =  0             ;
 }
 
 Meshline::~Meshline() {
@@ -40,6 +42,7 @@ Meshline* Meshline::copy() {
 	 returnvalue->stop_        = this->stop_;
 	 returnvalue->multiplicity_= this->multiplicity_;
 	 returnvalue->type_        = this->type_;
+	 returnvalue->order_       = this->order_;
 	 return returnvalue;
 }
 
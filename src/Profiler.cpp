@@ -180,6 +180,23 @@ void Profiler::report (std::ostream& os) const
        <<"\nTotal time            |"<< tit->second;
   os <<"======================================================================="
      << std::endl;
+
+  // Print the event counters, if any
+  if (myCounters.empty()) return;
+  os <<"Counter               |               count"
+     <<"\n----------------------+--------------------\n";
+  std::map<std::string,size_t>::const_iterator cit;
+  for (cit = myCounters.begin(); cit != myCounters.end(); cit++)
+  {
+    if (cit->first.size() >= 22)
+      os << cit->first.substr(0,22) <<'|';
+    else
+      os << cit->first << std::string(22-cit->first.size(),' ') <<'|';
+    os.width(20);
+    os << cit->second <<'\n';
+  }
+  os <<"======================================================================="
+     << std::endl;
 }
 
 
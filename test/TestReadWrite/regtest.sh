@@ -5,7 +5,18 @@ testDir=`dirname $2`
 
 cd /tmp
 readarray < $2 &> LR_regtest.log
-$myApp $MAPFILE 
+
+# input files (*.lr) are given relative to the test directory
+args=""
+inputFile=""
+for arg in $MAPFILE; do
+	if [[ $arg == *.lr ]]; then
+		arg=$testDir/$arg
+		inputFile=$arg
+	fi
+	args="$args $arg"
+done
+$myApp $args
 
 diff -u TestReadWrite.lr TestReadWrite2.lr
 result=$?
@@ -13,6 +24,11 @@ if [ $result -eq 0 ]; then
 	diff -u TestReadWrite.lr TestReadWrite3.lr
 	result=$?
 fi
+# files written by earlier versions should be reproduced exactly (same function order and ids)
+if [ $result -eq 0 ] && [ -n "$inputFile" ]; then
+	diff -u $inputFile TestReadWrite.lr
+	result=$?
+fi
 
 rm -f TestReadWrite.lr TestReadWrite2.lr TestReadWrite3.lr TestReadWrite4.lr
 